@@ -1,19 +1,41 @@
 #include <string>
 
+#include <string_view>
+
 #include <vector>
 
 #include <map>
 
-#include <queue>
+#include <unordered_map>
+
+#include <deque>
+
+#include <functional>
 
 #include <ctime>
 
+#include <cstring>
+
+#include <cstdint>
+
+#include <atomic>
+
+#include <bit>
+
 #include <stdexcept>
 
 #include <mutex>
+#include <shared_mutex>
 #include <thread>
+#include <condition_variable>
+#include <chrono>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 // Forward declarations
+class ConferenceStore;
 class Conference;
 class User;
 class Booking;
@@ -27,99 +49,1061 @@ struct Timestamp {
     }
 };
 
-class Conference {
-    private: string name;
-    string location;
-    vector < string > topics;
-    Timestamp startTime;
-    Timestamp endTime;
-    int totalSlots;
-    int availableSlots;
-
-    public: Conference(const string & name,
+// Hash used by FlatHashMap. Integer keys are run through a 64-bit finalizer
+// because packed keys (e.g. user << 32 | conference) differ only in a few
+// bits; strings and string_views hash identically so either can be looked up.
+struct FlatHash {
+    size_t operator()(uint64_t key) const {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return static_cast < size_t > (key);
+    }
+    size_t operator()(string_view key) const {
+        return hash < string_view > ()(key);
+    }
+};
+
+// Open-addressing hash map with linear probing over one flat slot array.
+// A parallel control byte per slot holds 7 bits of the hash (or EMPTY), so a
+// probe compares keys only when those bits match. Erase shifts the rest of
+// the probe run back instead of leaving tombstones, so a table with steady
+// insert/erase churn never needs to rehash. Lookups are templated on the key
+// type to allow heterogeneous (string_view) lookup.
+template < typename Key, typename Value, typename Hash = FlatHash, typename KeyEqual = equal_to < >>
+    class FlatHashMap {
+        private: static constexpr uint8_t EMPTY = 0x80;
+
+        struct Slot {
+            Key key;
+            Value value;
+        };
+
+        vector < uint8_t > control;
+        vector < Slot > slots;
+        size_t count = 0;
+        Hash hasher;
+        KeyEqual equal;
+
+        static uint8_t fragment(size_t hash) {
+            return static_cast < uint8_t > (hash >> (sizeof(size_t) * 8 - 7));
+        }
+
+        template < typename K >
+            size_t findIndex(const K & key) const {
+                if (slots.empty()) {
+                    return SIZE_MAX;
+                }
+                size_t hash = hasher(key);
+                uint8_t tag = fragment(hash);
+                size_t mask = slots.size() - 1;
+                for (size_t i = hash & mask;; i = (i + 1) & mask) {
+                    if (control[i] == EMPTY) {
+                        return SIZE_MAX;
+                    }
+                    if (control[i] == tag && equal(slots[i].key, key)) {
+                        return i;
+                    }
+                }
+            }
+
+        void rehash(size_t capacity) {
+            vector < uint8_t > oldControl(capacity, EMPTY);
+            vector < Slot > oldSlots(capacity);
+            oldControl.swap(control);
+            oldSlots.swap(slots);
+            size_t mask = capacity - 1;
+            for (size_t i = 0; i < oldSlots.size(); ++i) {
+                if (oldControl[i] == EMPTY) {
+                    continue;
+                }
+                size_t hash = hasher(oldSlots[i].key);
+                size_t j = hash & mask;
+                while (control[j] != EMPTY) {
+                    j = (j + 1) & mask;
+                }
+                control[j] = fragment(hash);
+                slots[j] = move(oldSlots[i]);
+            }
+        }
+
+        public: size_t size() const {
+            return count;
+        }
+
+        bool empty() const {
+            return count == 0;
+        }
+
+        void swap(FlatHashMap & other) {
+            control.swap(other.control);
+            slots.swap(other.slots);
+            std::swap(count, other.count);
+        }
+
+        // Sized so that n entries stay under a 7/8 load factor
+        void reserve(size_t n) {
+            size_t capacity = 16;
+            while (n * 8 > capacity * 7) {
+                capacity *= 2;
+            }
+            if (capacity > slots.size()) {
+                rehash(capacity);
+            }
+        }
+
+        template < typename K >
+            Value * find(const K & key) {
+                size_t i = findIndex(key);
+                return i == SIZE_MAX ? nullptr : & slots[i].value;
+            }
+
+        template < typename K >
+            const Value * find(const K & key) const {
+                size_t i = findIndex(key);
+                return i == SIZE_MAX ? nullptr : & slots[i].value;
+            }
+
+        // Inserts unless the key is present; returns the stored value and
+        // whether it was inserted
+        pair < Value * , bool > insert(const Key & key,
+            const Value & value) {
+            size_t existing = findIndex(key);
+            if (existing != SIZE_MAX) {
+                return {
+                    & slots[existing].value, false
+                };
+            }
+            if ((count + 1) * 8 > slots.size() * 7) {
+                reserve(max < size_t > (count * 2, 8));
+            }
+            size_t hash = hasher(key);
+            size_t mask = slots.size() - 1;
+            size_t i = hash & mask;
+            while (control[i] != EMPTY) {
+                i = (i + 1) & mask;
+            }
+            control[i] = fragment(hash);
+            slots[i].key = key;
+            slots[i].value = value;
+            count++;
+            return {
+                & slots[i].value, true
+            };
+        }
+
+        Value & operator[](const Key & key) {
+            return * insert(key, Value()).first;
+        }
+
+        // Backward-shift deletion: later entries of the same probe run move
+        // into the hole as long as that does not put them before their home
+        // slot.
+        template < typename K >
+            bool erase(const K & key) {
+                size_t hole = findIndex(key);
+                if (hole == SIZE_MAX) {
+                    return false;
+                }
+                size_t mask = slots.size() - 1;
+                for (size_t next = (hole + 1) & mask; control[next] != EMPTY; next = (next + 1) & mask) {
+                    size_t home = hasher(slots[next].key) & mask;
+                    if (((next - home) & mask) >= ((next - hole) & mask)) {
+                        control[hole] = control[next];
+                        slots[hole] = move(slots[next]);
+                        hole = next;
+                    }
+                }
+                control[hole] = EMPTY;
+                slots[hole] = Slot();
+                count--;
+                return true;
+            }
+
+        template < typename Visitor >
+            void forEach(Visitor visit) const {
+                for (size_t i = 0; i < slots.size(); ++i) {
+                    if (control[i] != EMPTY) {
+                        visit(slots[i].key, slots[i].value);
+                    }
+                }
+            }
+    };
+
+// Dense integer id handed out for an external string id at the API boundary.
+// Users, conferences and bookings are all stored and indexed by handle.
+typedef uint32_t Handle;
+const Handle INVALID_HANDLE = UINT32_MAX;
+
+// Interns external string ids into handles 0, 1, 2, ... in insertion order
+class SymbolTable {
+    private: deque < string > names; // handle -> name, never moved once added
+    FlatHashMap < string_view,
+    Handle > handles; // views into names -> handle
+
+    public: Handle intern(string_view name) {
+        if (const Handle * existing = handles.find(name)) {
+            return * existing;
+        }
+        Handle handle = static_cast < Handle > (names.size());
+        names.emplace_back(name);
+        handles.insert(names.back(), handle);
+        return handle;
+    }
+
+    Handle find(string_view name) const {
+        const Handle * handle = handles.find(name);
+        return handle ? * handle : INVALID_HANDLE;
+    }
+
+    const string & name(Handle handle) const {
+        return names[handle];
+    }
+
+    size_t size() const {
+        return names.size();
+    }
+};
+
+// Fixed-size records in slabs of SLAB_SIZE that are never moved or freed, so a
+// handle stays valid for the record's lifetime. Released slots go on a free
+// list and are reused first; once the pool has grown to its working set,
+// allocate and release never touch the heap.
+template < typename T >
+    class SlabPool {
+        private: static constexpr size_t SLAB_BITS = 12;
+        static constexpr size_t SLAB_SIZE = size_t(1) << SLAB_BITS;
+
+        vector < unique_ptr < T[] >> slabs;
+        vector < Handle > freeList;
+        Handle next = 0; // first never-used handle
+
+        public: Handle allocate(const T & value) {
+            Handle handle;
+            if (!freeList.empty()) {
+                handle = freeList.back();
+                freeList.pop_back();
+            } else {
+                handle = next++;
+                if ((handle >> SLAB_BITS) == slabs.size()) {
+                    slabs.emplace_back(new T[SLAB_SIZE]);
+                    freeList.reserve(slabs.size() * SLAB_SIZE);
+                }
+            }
+            ( * this)[handle] = value;
+            return handle;
+        }
+
+        void release(Handle handle) {
+            ( * this)[handle] = T();
+            freeList.push_back(handle);
+        }
+
+        T & operator[](Handle handle) {
+            return slabs[handle >> SLAB_BITS][handle & (SLAB_SIZE - 1)];
+        }
+
+        const T & operator[](Handle handle) const {
+            return slabs[handle >> SLAB_BITS][handle & (SLAB_SIZE - 1)];
+        }
+
+        // Live records
+        size_t size() const {
+            return next - freeList.size();
+        }
+
+        // Every handle ever allocated is below this; released slots in that
+        // range hold a default-constructed T
+        Handle limit() const {
+            return next;
+        }
+    };
+
+// Booking ids are 64-bit: the top SHARD_BITS select a generator shard and the
+// rest is that shard's sequence number, so ids are unique for the lifetime of
+// the system no matter how fast a user rebooks.
+typedef uint64_t BookingId;
+
+class BookingIdGenerator {
+    public: static const int SHARD_BITS = 6;
+    static const unsigned NUM_SHARDS = 1u << SHARD_BITS;
+    static const int SEQUENCE_BITS = 64 - SHARD_BITS;
+
+    private:
+        // One cache line per shard so that shards never contend
+        struct alignas(64) Counter {
+            atomic < uint64_t > next {
+                0
+            };
+        };
+    Counter counters[NUM_SHARDS];
+
+    // Crockford base32: no I, L, O or U, so ids are unambiguous when read out
+    static constexpr const char * DIGITS = "0123456789ABCDEFGHJKMNPQRSTVWXYZ";
+
+    public: static unsigned shardOf(BookingId id) {
+        return static_cast < unsigned > (id >> SEQUENCE_BITS);
+    }
+
+    BookingId next(unsigned shard) {
+        uint64_t sequence = counters[shard % NUM_SHARDS].next.fetch_add(1, memory_order_relaxed);
+        return (static_cast < uint64_t > (shard % NUM_SHARDS) << SEQUENCE_BITS) | sequence;
+    }
+
+    // At most 13 characters, which stays within the small-string buffer
+    static string encode(BookingId id) {
+        char buffer[13];
+        int pos = 13;
+        do {
+            buffer[--pos] = DIGITS[id & 31];
+            id >>= 5;
+        } while (id != 0);
+        return string(buffer + pos, buffer + 13);
+    }
+
+    // Only accepts the canonical form produced by encode()
+    static bool decode(const string & text, BookingId & id) {
+        if (text.empty() || text.size() > 13 || (text.size() > 1 && text[0] == '0')) {
+            return false;
+        }
+        if (text.size() == 13 && text[0] > 'F') {
+            return false; // more than 64 bits
+        }
+        id = 0;
+        for (char c: text) {
+            const char * digit = c == '\0' ? nullptr : strchr(DIGITS, c);
+            if (!digit) {
+                return false;
+            }
+            id = (id << 5) | static_cast < uint64_t > (digit - DIGITS);
+        }
+        return true;
+    }
+};
+
+// Topics are interned globally; a topic's handle is its bit in a TopicMask.
+// Conferences carry at most 10 topics and users at most 50, so matching two
+// of them is an AND plus a popcount over a few words. Only topics some
+// conference covers get a bit: a user interest no conference has yet cannot
+// affect any match, so it waits until a conference brings the topic in.
+// The catalog may hold any number of topics, but past TOPIC_MASK_BITS they
+// share bits (handle modulo the width), so recommendation scores over a
+// larger catalog can count a topic as shared when only its bit-mate is.
+// Topic queries go through TopicIndex by handle and stay exact.
+const size_t TOPIC_MASK_BITS = 256;
+
+// Number of distinct names in `names`
+inline size_t countDistinct(const vector < string > & names) {
+    vector < string_view > sorted(names.begin(), names.end());
+    sort(sorted.begin(), sorted.end());
+    return unique(sorted.begin(), sorted.end()) - sorted.begin();
+}
+
+struct alignas(32) TopicMask {
+    static const size_t WORDS = TOPIC_MASK_BITS / 64;
+    uint64_t words[WORDS] = {};
+
+    void set(Handle topic) {
+        topic %= TOPIC_MASK_BITS;
+        words[topic / 64] |= uint64_t(1) << (topic % 64);
+    }
+    bool test(Handle topic) const {
+        topic %= TOPIC_MASK_BITS;
+        return (words[topic / 64] >> (topic % 64)) & 1;
+    }
+    int count() const {
+        int total = 0;
+        for (uint64_t word: words) {
+            total += popcount(word);
+        }
+        return total;
+    }
+    // Number of topics shared with `other`
+    int overlap(const TopicMask & other) const {
+        int total = 0;
+        for (size_t i = 0; i < WORDS; i++) {
+            total += popcount(words[i] & other.words[i]);
+        }
+        return total;
+    }
+};
+
+// scores[i] = number of topics masks[i] shares with query. This is the inner
+// loop of recommendation scoring, so with AVX2 each 256-bit mask is ANDed
+// and popcounted in registers (nibble lookup + SAD) instead of word by word.
+void scoreTopicOverlap(const TopicMask * masks, size_t count,
+    const TopicMask & query, uint8_t * scores) {
+#if defined(__AVX2__)
+    const __m256i queryBits = _mm256_load_si256(reinterpret_cast < const __m256i * > (query.words));
+    const __m256i nibbleCounts = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibble = _mm256_set1_epi8(0x0f);
+    for (size_t i = 0; i < count; i++) {
+        __m256i bits = _mm256_and_si256(_mm256_load_si256(reinterpret_cast < const __m256i * > (masks[i].words)), queryBits);
+        __m256i low = _mm256_shuffle_epi8(nibbleCounts, _mm256_and_si256(bits, lowNibble));
+        __m256i high = _mm256_shuffle_epi8(nibbleCounts, _mm256_and_si256(_mm256_srli_epi16(bits, 4), lowNibble));
+        __m256i sums = _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256());
+        __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+        scores[i] = static_cast < uint8_t > (_mm_cvtsi128_si64(half) + _mm_extract_epi64(half, 1));
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        scores[i] = static_cast < uint8_t > (masks[i].overlap(query));
+    }
+#endif
+}
+
+// Upper bound on Conference duration, relied on by the time index
+const time_t MAX_CONFERENCE_DURATION = 12 * 3600;
+// Conferences with at least this many slots keep their seats in a SeatPool
+const int SHARDED_SEATS_THRESHOLD = 4096;
+
+// A small number fixed per thread, handed out in order of first use; spreads
+// threads over per-thread slots of contended structures
+inline unsigned threadSlot() {
+    static atomic < unsigned > nextSlot {
+        0
+    };
+    thread_local unsigned slot = nextSlot.fetch_add(1, memory_order_relaxed);
+    return slot;
+}
+
+// Takes one seat from a counter unless it is empty; lock-free. Returns the
+// count the seat was taken from, 0 when there was none.
+inline int takeSeat(atomic_ref < int > counter) {
+    int available = counter.load(memory_order_relaxed);
+    while (available > 0) {
+        if (counter.compare_exchange_weak(available, available - 1, memory_order_acq_rel, memory_order_relaxed)) {
+            return available;
+        }
+    }
+    return 0;
+}
+
+// Seats of a mega-conference split into per-thread sub-pools, each on its own
+// cache line, so simultaneous seat takes do not all bounce one counter. The
+// rest of a booking (its record, the roster, the waitlist) is still made
+// under the conference's stripe lock, so bookings for one conference
+// serialize there; the pools only take the counter out of that critical
+// section. A booking takes a seat from its own sub-pool, then from the
+// central reserve, then steals from the other sub-pools. Seats are only
+// ever moved one at a time by a single CAS, never created, so confirmations
+// cannot exceed totalSlots, and a full pass that finds every pool empty
+// while no seat is being given back means the conference is sold out.
+class SeatPool {
+    public: static const unsigned SHARDS = 16;
+
+    private: struct alignas(64) Shard {
+        int seats = 0;
+    };
+    Shard shards[SHARDS];
+
+    atomic_ref < int > shardCounter(unsigned shard) const {
+        return atomic_ref < int > (const_cast < int & > (shards[shard].seats));
+    }
+
+    public:
+        // Spreads seats evenly over the sub-pools and returns the remainder,
+        // which the caller keeps as the central reserve
+        int fill(int seats) {
+            int each = seats / static_cast < int > (SHARDS);
+            for (unsigned i = 0; i < SHARDS; i++) {
+                shardCounter(i).store(each, memory_order_relaxed);
+            }
+            return seats - each * static_cast < int > (SHARDS);
+        }
+
+    bool take(atomic_ref < int > central) {
+        unsigned own = threadSlot() % SHARDS;
+        if (takeSeat(shardCounter(own)) || takeSeat(central)) {
+            return true;
+        }
+        for (unsigned i = 1; i < SHARDS; i++) {
+            if (takeSeat(shardCounter((own + i) % SHARDS))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void give() {
+        shardCounter(threadSlot() % SHARDS).fetch_add(1, memory_order_acq_rel);
+    }
+
+    int available() const {
+        int total = 0;
+        for (unsigned i = 0; i < SHARDS; i++) {
+            total += shardCounter(i).load(memory_order_relaxed);
+        }
+        return total;
+    }
+};
+
+// The catalog stored column-wise: one array per field, indexed by conference
+// handle. Bulk questions over the catalog scan only the columns they need in
+// tight loops, and Conference is a view of one row. availableSlots is the
+// only column written after add(); every access to it goes through
+// atomic_ref, so seat counts can be read without any lock. For conferences
+// of SHARDED_SEATS_THRESHOLD slots or more it holds only the central reserve
+// and the rest of the free seats sit in the conference's SeatPool.
+// Catalog-wide seat aggregates are kept as running tallies rather than
+// scanned: atomic loads keep a column scan from vectorizing.
+class ConferenceStore {
+    private: vector < string > names;
+    vector < string > locations;
+    vector < TopicMask > topics;
+    vector < time_t > startTimes;
+    vector < time_t > endTimes;
+    vector < int > totalSlots;
+    vector < int > availableSlots;
+    // conference -> seat pool, null unless the conference is sharded
+    vector < unique_ptr < SeatPool >> seatPools;
+    vector < Handle > shardedConferences;
+
+    // Free seats and sold-out count of the unsharded conferences, split by
+    // handle over cache lines so a seat change only touches its own line.
+    // Updated with the seat counter's CAS on 0 <-> 1 transitions; sharded
+    // conferences are summed from their pools when asked.
+    static const unsigned SEAT_TALLIES = 64;
+    struct alignas(64) SeatTally {
+        atomic < long long > freeSeats {
+            0
+        };
+        atomic < long long > soldOut {
+            0
+        };
+    };
+    SeatTally tallies[SEAT_TALLIES];
+
+    SeatTally & tallyOf(Handle conference) {
+        return tallies[conference % SEAT_TALLIES];
+    }
+    // A seat was taken from a counter that held `before`
+    void tallyTaken(Handle conference, int before) {
+        SeatTally & tally = tallyOf(conference);
+        tally.freeSeats.fetch_sub(1, memory_order_relaxed);
+        if (before == 1) {
+            tally.soldOut.fetch_add(1, memory_order_relaxed);
+        }
+    }
+    // A seat was returned to a counter that held `before`
+    void tallyReturned(Handle conference, int before) {
+        SeatTally & tally = tallyOf(conference);
+        tally.freeSeats.fetch_add(1, memory_order_relaxed);
+        if (before == 0) {
+            tally.soldOut.fetch_sub(1, memory_order_relaxed);
+        }
+    }
+
+    friend class Conference;
+
+    atomic_ref < int > seatCounter(Handle conference) const {
+        return atomic_ref < int > (const_cast < int & > (availableSlots[conference]));
+    }
+    int centralSeats(size_t conference) const {
+        return seatCounter(static_cast < Handle > (conference)).load(memory_order_relaxed);
+    }
+    int seats(Handle conference) const {
+        const SeatPool * pool = seatPools[conference].get();
+        return centralSeats(conference) + (pool ? pool -> available() : 0);
+    }
+
+    public: Handle add(const string & name,
         const string & location,
-            const vector < string > & topics,
+            const TopicMask & topics,
                 const Timestamp & start,
                     const Timestamp & end, int slots);
 
+    // Throws unless a conference with these fields may be added
+    static void validate(size_t topicCount,
+        const Timestamp & start,
+            const Timestamp & end, int slots);
+
+    size_t size() const {
+        return startTimes.size();
+    }
+
+    Conference operator[](Handle conference);
+    // Views share one type; a view taken from a const store is const too
+    const Conference operator[](Handle conference) const;
+
+    const vector < TopicMask > & getTopicColumn() const {
+        return topics;
+    }
+
+    // Catalog-wide aggregates. Seat aggregates add up the tallies and the
+    // few sharded conferences, a relaxed snapshot that may straddle
+    // concurrent bookings. countStartingBetween scans one column with a
+    // branch-free loop body so the compiler can vectorize it.
+    long long totalAvailableSlots() const {
+        long long total = 0;
+        for (const SeatTally & tally: tallies) {
+            total += tally.freeSeats.load(memory_order_relaxed);
+        }
+        for (Handle conference: shardedConferences) {
+            total += seats(conference);
+        }
+        return total;
+    }
+
+    size_t countStartingBetween(time_t from, time_t to) const {
+        size_t count = 0;
+        for (size_t i = 0; i < startTimes.size(); i++) {
+            count += (startTimes[i] >= from) & (startTimes[i] < to);
+        }
+        return count;
+    }
+
+    size_t countSoldOut() const {
+        long long count = 0;
+        for (const SeatTally & tally: tallies) {
+            count += tally.soldOut.load(memory_order_relaxed);
+        }
+        for (Handle conference: shardedConferences) {
+            count += seats(conference) == 0;
+        }
+        return static_cast < size_t > (count);
+    }
+};
+
+class Conference {
+    private: ConferenceStore * store;
+    Handle handle;
+
+    public: Conference(ConferenceStore * store, Handle handle): store(store), handle(handle) {}
+
     public: bool decreaseAvailableSlots();
     void increaseAvailableSlots();
+    // Wait-free; the count may be stale by the time the caller acts on it
     int getAvailableSlots() const {
-        return availableSlots;
+        return store -> seats(handle);
+    }
+    int getTotalSlots() const {
+        return store -> totalSlots[handle];
     }
     bool hasStarted() const;
     Timestamp getStartTime() const {
-        return startTime;
+        return {
+            store -> startTimes[handle]
+        };
     }
     Timestamp getEndTime() const {
-        return endTime;
+        return {
+            store -> endTimes[handle]
+        };
     }
 
     bool hasSlotAvailable() const;
     bool isTimeOverlapping(const Timestamp & start,
         const Timestamp & end) const;
     const string & getName() const;
+    const string & getLocation() const {
+        return store -> locations[handle];
+    }
+    const TopicMask & getTopics() const {
+        return store -> topics[handle];
+    }
     // Add other getters as needed
 };
 
-bool Conference::decreaseAvailableSlots() {
-    if (availableSlots > 0) {
-        availableSlots--;
-        return true;
-    }
-    return false;
-}
-
-void Conference::increaseAvailableSlots() {
-    if (availableSlots < totalSlots) {
-        availableSlots++;
+Handle ConferenceStore::add(const string & name,
+    const string & location,
+        const TopicMask & _topics,
+            const Timestamp & start,
+                const Timestamp & end, int slots) {
+    validate(_topics.count(), start, end, slots);
+
+    names.push_back(name);
+    locations.push_back(location);
+    topics.push_back(_topics);
+    startTimes.push_back(start.time);
+    endTimes.push_back(end.time);
+    totalSlots.push_back(slots);
+    Handle conference = static_cast < Handle > (startTimes.size() - 1);
+    if (slots >= SHARDED_SEATS_THRESHOLD) {
+        seatPools.push_back(make_unique < SeatPool > ());
+        availableSlots.push_back(seatPools.back() -> fill(slots));
+        shardedConferences.push_back(conference);
+    } else {
+        seatPools.push_back(nullptr);
+        availableSlots.push_back(slots);
+        tallyOf(conference).freeSeats.fetch_add(slots, memory_order_relaxed);
     }
+    return conference;
 }
 
-bool Conference::hasStarted() const {
-    return time(nullptr) >= startTime.time;
-}
-
-Conference::Conference(const string & _name,
-    const string & _location,
-        const vector < string > & _topics,
-            const Timestamp & start,
-                const Timestamp & end, int slots) {
-    if (_topics.size() > 10) {
+void ConferenceStore::validate(size_t topicCount,
+    const Timestamp & start,
+        const Timestamp & end, int slots) {
+    if (topicCount > 10) {
         throw runtime_error("Maximum 10 topics allowed");
     }
     if (slots <= 0) {
         throw runtime_error("Slots must be greater than 0");
     }
-    if (end.time - start.time > 12 * 3600) {
+    if (end.time - start.time > MAX_CONFERENCE_DURATION) {
         throw runtime_error("Conference duration cannot exceed 12 hours");
     }
     if (start.time >= end.time) {
         throw runtime_error("Start time must be before end time");
     }
+}
+
+Conference ConferenceStore::operator[](Handle conference) {
+    return Conference(this, conference);
+}
+
+const Conference ConferenceStore::operator[](Handle conference) const {
+    return Conference(const_cast < ConferenceStore * > (this), conference);
+}
+
+// Seat accounting is a compare-and-swap loop on the conference's counter,
+// bounded by 0 and totalSlots: it never blocks, and a failed CAS means some
+// other booking made progress. Sharded conferences go through their SeatPool;
+// a seat given back there lands in the caller's sub-pool.
+bool Conference::decreaseAvailableSlots() {
+    if (SeatPool * pool = store -> seatPools[handle].get()) {
+        return pool -> take(store -> seatCounter(handle));
+    }
+    int before = takeSeat(store -> seatCounter(handle));
+    if (before == 0) {
+        return false;
+    }
+    store -> tallyTaken(handle, before);
+    return true;
+}
+
+void Conference::increaseAvailableSlots() {
+    if (SeatPool * pool = store -> seatPools[handle].get()) {
+        pool -> give();
+        return;
+    }
+    atomic_ref < int > counter = store -> seatCounter(handle);
+    int total = store -> totalSlots[handle];
+    int available = counter.load(memory_order_relaxed);
+    while (available < total) {
+        if (counter.compare_exchange_weak(available, available + 1, memory_order_acq_rel, memory_order_relaxed)) {
+            store -> tallyReturned(handle, available);
+            return;
+        }
+    }
+}
 
-    name = _name;
-    location = _location;
-    topics = _topics;
-    startTime = start;
-    endTime = end;
-    totalSlots = slots;
-    availableSlots = slots;
+bool Conference::hasStarted() const {
+    return time(nullptr) >= store -> startTimes[handle];
 }
 
 bool Conference::hasSlotAvailable() const {
-    return availableSlots > 0;
+    return store -> seats(handle) > 0;
 }
 
 bool Conference::isTimeOverlapping(const Timestamp & start,
     const Timestamp & end) const {
-    return !(end.time <= startTime.time || start.time >= endTime.time);
+    return !(end.time <= store -> startTimes[handle] || start.time >= store -> endTimes[handle]);
 }
 
 const string & Conference::getName() const {
-    return name;
+    return store -> names[handle];
 }
 
+// Conferences bucketed by the hour their start time falls in. Buckets are
+// ordered and each keeps its entries sorted by (start, conference), so a
+// window query touches only the hours it spans. No conference lasts longer
+// than MAX_CONFERENCE_DURATION, so everything overlapping [start, end) sits in
+// the buckets from start - MAX_CONFERENCE_DURATION up to end.
+class CalendarIndex {
+    public: static const time_t BUCKET_SECONDS = 3600;
+
+    // Position in the calendar order; queries can resume strictly after one
+    struct Cursor {
+        time_t start;
+        Handle conference;
+    };
+
+    private: struct Entry {
+        time_t start;
+        time_t end;
+        Handle conference;
+
+        bool operator < (const Entry & other) const {
+            return start != other.start ? start < other.start : conference < other.conference;
+        }
+    };
+    map < time_t,
+    vector < Entry >> buckets; // bucket start -> entries ordered by (start, conference)
+
+    static time_t bucketOf(time_t time) {
+        return time - ((time % BUCKET_SECONDS) + BUCKET_SECONDS) % BUCKET_SECONDS;
+    }
+
+    public: void add(Handle conference,
+        const Timestamp & start,
+            const Timestamp & end) {
+        Entry entry {
+            start.time, end.time, conference
+        };
+        auto & bucket = buckets[bucketOf(start.time)];
+        bucket.insert(upper_bound(bucket.begin(), bucket.end(), entry), entry);
+    }
+
+    // Visits conferences with from <= start < to in calendar order, beginning
+    // after `after` when given. Stops early when visit returns false.
+    template < typename Visitor >
+        void forEachStarting(time_t from, time_t to,
+            const Cursor * after, Visitor visit) const {
+            Entry first {
+                from, 0, 0
+            };
+            if (after) {
+                first = max(first, Entry {
+                    after -> start, 0, after -> conference + 1
+                });
+            }
+            for (auto bucket = buckets.lower_bound(bucketOf(first.start)); bucket != buckets.end() && bucket -> first < to; ++bucket) {
+                auto & entries = bucket -> second;
+                for (auto it = lower_bound(entries.begin(), entries.end(), first); it != entries.end(); ++it) {
+                    if (it -> start >= to) {
+                        return;
+                    }
+                    if (!visit(it -> conference)) {
+                        return;
+                    }
+                }
+            }
+        }
+
+    template < typename Visitor >
+        void forEachOverlapping(const Timestamp & start,
+            const Timestamp & end, Visitor visit) const {
+            auto bucket = buckets.lower_bound(bucketOf(start.time - MAX_CONFERENCE_DURATION));
+            for (; bucket != buckets.end() && bucket -> first < end.time; ++bucket) {
+                for (const Entry & entry: bucket -> second) {
+                    if (entry.start < end.time && entry.end > start.time) {
+                        visit(entry.conference);
+                    }
+                }
+            }
+        }
+};
+
+// Conferences ordered by (start, conference), kept as a run of sorted chunks
+// of CHUNK to 2 * CHUNK entries. Adding one shifts entries within its chunk
+// only, so building a list of n conferences in any start order stays near
+// n log n instead of the n^2 of inserting into one sorted vector, while scans
+// still read long contiguous runs.
+class StartList {
+    public: typedef pair < time_t,
+    Handle > Entry;
+    static const size_t CHUNK = 512;
+
+    // Position in the list that only moves forward
+    struct Cursor {
+        size_t chunk;
+        size_t index;
+    };
+
+    private: vector < vector < Entry >> chunks; // each sorted and non-empty, in order
+    size_t count = 0;
+
+    // First position at or after `from` whose entry is >= target, found by
+    // doubling the step and then binary searching the last step
+    static size_t gallop(const vector < Entry > & list, size_t from,
+        const Entry & target) {
+        size_t step = 1;
+        size_t low = from;
+        size_t high = from;
+        while (high < list.size() && list[high] < target) {
+            low = high + 1;
+            high = from + step;
+            step *= 2;
+        }
+        high = min(high, list.size());
+        return lower_bound(list.begin() + low, list.begin() + high, target) - list.begin();
+    }
+
+    // First chunk at or after `from` holding an entry >= target
+    size_t chunkFor(size_t from,
+        const Entry & target) const {
+        return partition_point(chunks.begin() + from, chunks.end(), [ & ](const vector < Entry > & chunk) {
+            return chunk.back() < target;
+        }) - chunks.begin();
+    }
+
+    public: void add(time_t start, Handle conference) {
+        Entry entry(start, conference);
+        count++;
+        if (chunks.empty()) {
+            chunks.push_back({
+                entry
+            });
+            return;
+        }
+        // The last chunk starting at or before the entry
+        auto chunk = upper_bound(chunks.begin(), chunks.end(), entry, [](const Entry & value,
+            const vector < Entry > & chunk) {
+            return value < chunk.front();
+        });
+        if (chunk != chunks.begin()) {
+            --chunk;
+        }
+        chunk -> insert(upper_bound(chunk -> begin(), chunk -> end(), entry), entry);
+        if (chunk -> size() > 2 * CHUNK) {
+            vector < Entry > tail(chunk -> begin() + CHUNK, chunk -> end());
+            chunk -> resize(CHUNK);
+            chunks.insert(chunk + 1, move(tail));
+        }
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    Cursor begin() const {
+        return Cursor {
+            0, 0
+        };
+    }
+
+    // Moves the cursor to the first entry >= target and returns it, or
+    // nullptr past the end. Whole chunks are skipped by their last entry,
+    // then the search gallops from the cursor, so ascending targets cost
+    // little each.
+    const Entry * seek(Cursor & cursor,
+        const Entry & target) const {
+        if (cursor.chunk < chunks.size() && chunks[cursor.chunk].back() < target) {
+            cursor.chunk = chunkFor(cursor.chunk, target);
+            cursor.index = 0;
+        }
+        if (cursor.chunk == chunks.size()) {
+            return nullptr;
+        }
+        cursor.index = gallop(chunks[cursor.chunk], cursor.index, target);
+        return & chunks[cursor.chunk][cursor.index];
+    }
+
+    // Visits entries starting after `after` in order. Stops early when visit
+    // returns false.
+    template < typename Visitor >
+        void forEachAfter(time_t after, Visitor visit) const {
+            Entry first(after, INVALID_HANDLE);
+            for (size_t chunk = chunkFor(0, first); chunk < chunks.size(); chunk++) {
+                auto & entries = chunks[chunk];
+                for (auto it = upper_bound(entries.begin(), entries.end(), first); it != entries.end(); ++it) {
+                    if (!visit( * it)) {
+                        return;
+                    }
+                }
+            }
+        }
+};
+
+// Inverted index from topic to the conferences covering it. Each posting list
+// is ordered by (start time, conference), so "upcoming" is a search and
+// multi-topic queries merge or intersect ordered lists.
+class TopicIndex {
+    private: typedef StartList::Entry Posting;
+    vector < StartList > postings; // topic -> postings ordered by start
+
+    public: void add(Handle conference, time_t start,
+        const vector < Handle > & topics) {
+        for (Handle topic: topics) {
+            if (postings.size() <= topic) {
+                postings.resize(topic + 1);
+            }
+            postings[topic].add(start, conference);
+        }
+    }
+
+    // Conferences starting after `now` that cover every topic
+    vector < Handle > findAll(const vector < Handle > & topics, time_t now) const {
+        vector < Handle > result;
+        vector < const StartList * > lists;
+        for (Handle topic: topics) {
+            if (topic >= postings.size()) {
+                return result;
+            }
+            lists.push_back( & postings[topic]);
+        }
+        if (lists.empty()) {
+            return result;
+        }
+        sort(lists.begin(), lists.end(), [](const StartList * a,
+            const StartList * b) {
+            return a -> size() < b -> size();
+        });
+
+        // Walk the shortest list and gallop through the others
+        vector < StartList::Cursor > cursors;
+        for (const StartList * list: lists) {
+            cursors.push_back(list -> begin());
+        }
+        lists[0] -> forEachAfter(now, [ & ](const Posting & posting) {
+            for (size_t j = 1; j < lists.size(); j++) {
+                const Posting * next = lists[j] -> seek(cursors[j], posting);
+                if (!next) {
+                    return false;
+                }
+                if ( * next != posting) {
+                    return true;
+                }
+            }
+            result.push_back(posting.second);
+            return true;
+        });
+        return result;
+    }
+
+    // Conferences starting after `now` that cover at least one topic
+    vector < Handle > findAny(const vector < Handle > & topics, time_t now) const {
+        vector < Posting > merged;
+        for (Handle topic: topics) {
+            if (topic < postings.size()) {
+                postings[topic].forEachAfter(now, [ & ](const Posting & posting) {
+                    merged.push_back(posting);
+                    return true;
+                });
+            }
+        }
+
+        // Emit each conference once, in start order
+        sort(merged.begin(), merged.end());
+        merged.erase(unique(merged.begin(), merged.end()), merged.end());
+        vector < Handle > result;
+        result.reserve(merged.size());
+        for (const Posting & posting: merged) {
+            result.push_back(posting.second);
+        }
+        return result;
+    }
+};
+
+// Conferences grouped by interned location. Each venue's list is ordered by
+// (start, conference), so venue queries read only that venue's conferences
+// and can search to the time range they need.
+class VenueIndex {
+    public: typedef StartList Schedule;
+
+    private: SymbolTable locations; // location -> venue handle
+    vector < Schedule > schedules; // venue handle -> conferences ordered by start
+
+    public: void add(Handle conference,
+        const string & location, time_t start) {
+        Handle venue = locations.intern(location);
+        if (venue == schedules.size()) {
+            schedules.emplace_back();
+        }
+        schedules[venue].add(start, conference);
+    }
+
+    // nullptr when no conference was ever held at this location
+    const Schedule * find(string_view location) const {
+        Handle venue = locations.find(location);
+        return venue == INVALID_HANDLE ? nullptr : & schedules[venue];
+    }
+};
+
 enum class BookingStatus {
     CONFIRMED,
     WAITLISTED,
@@ -128,49 +1112,102 @@ enum class BookingStatus {
 
 class User {
     private: string userId;
-    vector < string > interestedTopics;
-    map < string,
-    BookingStatus > bookingStatuses; // bookingId -> status
+    TopicMask interestedTopics;
+    struct Window {
+        time_t start;
+        time_t end;
+        Handle booking;
+    };
+    vector < Window > confirmedWindows; // CONFIRMED bookings by start, never overlapping
+    FlatHashMap < Handle,
+    Handle > waitlistedBookings; // booking -> conference of WAITLISTED bookings
+    FlatHashMap < Handle,
+    Handle > activeBookings; // conference -> non-canceled booking
+
+    vector < Window > ::const_iterator firstWindowFrom(time_t start) const {
+        return lower_bound(confirmedWindows.begin(), confirmedWindows.end(), start, [](const Window & window, time_t t) {
+            return window.start < t;
+        });
+    }
 
     public: User(const string & id,
-        const vector < string > & topics) {
-        if (topics.size() > 50) {
-            throw runtime_error("Maximum 50 interested topics allowed");
-        }
+        const TopicMask & topics) {
+        validateTopicCount(topics.count());
         userId = id;
         interestedTopics = topics;
     }
 
-    void addBooking(const string & bookingId, BookingStatus status) {
-        bookingStatuses[bookingId] = status;
+    static void validateTopicCount(size_t topicCount) {
+        if (topicCount > 50) {
+            throw runtime_error("Maximum 50 interested topics allowed");
+        }
     }
 
-    void updateBookingStatus(const string & bookingId, BookingStatus status) {
-        if (bookingStatuses.find(bookingId) != bookingStatuses.end()) {
-            bookingStatuses[bookingId] = status;
-        }
+    // Called when a conference first brings in a topic the user asked for
+    void addInterest(Handle topic) {
+        interestedTopics.set(topic);
+    }
+
+    void addWaitlistedBooking(Handle booking, Handle conference) {
+        waitlistedBookings[booking] = conference;
+    }
+
+    void removeWaitlistedBooking(Handle booking) {
+        waitlistedBookings.erase(booking);
+    }
+
+    void setActiveBooking(Handle conference, Handle booking) {
+        activeBookings[conference] = booking;
+    }
+
+    void clearActiveBooking(Handle conference) {
+        activeBookings.erase(conference);
+    }
+
+    Handle findActiveBooking(Handle conference) const {
+        const Handle * booking = activeBookings.find(conference);
+        return booking ? * booking : INVALID_HANDLE;
+    }
+
+    const FlatHashMap < Handle,
+    Handle > & getWaitlistedBookings() const {
+        return waitlistedBookings;
     }
 
-    void removeBooking(const string& bookingId) {
-        auto it = bookingStatuses.find(bookingId);
-        if (it != bookingStatuses.end()) {
-            bookingStatuses.erase(it);
+    void addConfirmedWindow(const Timestamp & start,
+        const Timestamp & end, Handle booking) {
+        auto it = confirmedWindows.begin() + (firstWindowFrom(start.time) - confirmedWindows.cbegin());
+        confirmedWindows.insert(it, Window {
+            start.time, end.time, booking
+        });
+    }
+
+    void removeConfirmedWindow(const Timestamp & start) {
+        auto it = firstWindowFrom(start.time);
+        if (it != confirmedWindows.end() && it -> start == start.time) {
+            confirmedWindows.erase(it);
         }
     }
 
-    vector < string > getActiveBookings() const {
-        vector < string > active;
-        for (const auto & [id, status]: bookingStatuses) {
-            if (status != BookingStatus::CANCELED) {
-                active.push_back(id);
-            }
+    // Confirmed windows are disjoint, so their ends are sorted like their
+    // starts and only the last window starting before `end` can overlap.
+    Handle findConflictingWindow(const Timestamp & start,
+        const Timestamp & end) const {
+        auto it = firstWindowFrom(end.time);
+        if (it == confirmedWindows.begin()) {
+            return INVALID_HANDLE;
         }
-        return active;
+        --it;
+        return it -> end > start.time ? it -> booking : INVALID_HANDLE;
     }
 
     const string & getUserId() const {
         return userId;
     }
+
+    const TopicMask & getInterestedTopics() const {
+        return interestedTopics;
+    }
 };
 
 // bool User::hasConflictingBooking(const Conference& conf) const {
@@ -196,21 +1233,24 @@ ostream & operator << (ostream & os,
 }
 
 class Booking {
-    private: string bookingId;
-    string userId;
-    string conferenceName;
+    private: BookingId id;
+    Handle user;
+    Handle conference;
     BookingStatus status;
     Timestamp confirmationDeadline; // for waitlisted bookings
 
-    public: Booking(): status(BookingStatus::CANCELED) {}
-    Booking(const string & userId,
-        const string & confName);
-    const string & getBookingId() const;
-    const string & getUserId() const {
-        return userId;
+    public: Booking(): id(0), user(INVALID_HANDLE), conference(INVALID_HANDLE), status(BookingStatus::CANCELED), confirmationDeadline {
+        0
+    } {}
+    Booking(BookingId id, Handle user, Handle conference);
+    BookingId getId() const {
+        return id;
+    }
+    Handle getUser() const {
+        return user;
     }
-    const string & getConferenceName() const {
-        return conferenceName;
+    Handle getConference() const {
+        return conference;
     }
     BookingStatus getStatus() const;
     void setStatus(BookingStatus newStatus);
@@ -222,17 +1262,14 @@ class Booking {
     }
 };
 
-Booking::Booking(const string & _userId,
-    const string & confName) {
-    userId = _userId;
-    conferenceName = confName;
+Booking::Booking(BookingId _id, Handle _user, Handle _conference) {
+    id = _id;
+    user = _user;
+    conference = _conference;
     status = BookingStatus::CONFIRMED; // Default status
-    // We'll generate proper ID later
-    bookingId = _userId + "_" + confName + "_" + to_string(time(nullptr));
-}
-
-const string & Booking::getBookingId() const {
-    return bookingId;
+    confirmationDeadline = {
+        0
+    }; // no offer yet
 }
 
 BookingStatus Booking::getStatus() const {
@@ -243,449 +1280,1560 @@ void Booking::setStatus(BookingStatus newStatus) {
     status = newStatus;
 }
 
-class ConferenceBookingSystem {
-    private: map < string,
-    Conference > conferences; // name -> Conference
-    map < string,
-    User > users; // userId -> User
-    map < string,
-    Booking > bookings; // bookingId -> Booking
-    map < string,
-    queue < string >> waitlists; // conferenceName -> queue of bookingIds
-
-    // Add mutexes for protecting shared resources
-    mutable mutex conference_mutex;
-    mutable mutex booking_mutex;
-    mutable mutex waitlist_mutex;
-
-        // Helper method to perform atomic booking operation
-    string atomicBookingOperation(const string& userId, const string& conferenceName) {
-        lock_guard<mutex> conf_lock(conference_mutex);
-        lock_guard<mutex> book_lock(booking_mutex);
-        lock_guard<mutex> wait_lock(waitlist_mutex);
-        
-        auto& conference = conferences.at(conferenceName);
-        
-        // Check if conference has started
-        if (conference.hasStarted()) {
-            throw runtime_error("Cannot book conference that has already started");
-        }
-        
-        // Check for existing booking
-        for (const auto& [id, booking] : bookings) {
-            if (booking.getUserId() == userId && 
-                booking.getConferenceName() == conferenceName &&
-                booking.getStatus() != BookingStatus::CANCELED) {
-                throw runtime_error("User already has an active booking for this conference with ID: " + id);
-            }
-        }
-        
-        // Check for conflicts
-        if (hasConflictingBooking(userId, conference)) {
-            throw runtime_error("User has a conflicting booking");
-        }
-        
-        // Create booking
-        Booking newBooking(userId, conferenceName);
-        string bookingId = newBooking.getBookingId();
-        
-        // Try to get a slot
-        if (conference.decreaseAvailableSlots()) {
-            newBooking.setStatus(BookingStatus::CONFIRMED);
-            removeFromOverlappingWaitlists(userId, conference);
+// FIFO of waitlisted bookings, kept as a doubly linked list threaded through
+// a hash map: every booking maps to its neighbours, so removing or rotating an
+// entry does not touch the rest of the queue and reuses the map's storage.
+// Bookings holding a confirmation offer are always a prefix of the queue:
+// offers go out in queue order, and a booking leaves the prefix when it is
+// removed or sent to the back.
+class Waitlist {
+    private: struct Links {
+        Handle prev = INVALID_HANDLE;
+        Handle next = INVALID_HANDLE;
+        bool offered = false;
+    };
+    FlatHashMap < Handle,
+    Links > links; // booking -> neighbours in queue order
+    Handle head = INVALID_HANDLE;
+    Handle tail = INVALID_HANDLE;
+    size_t offered = 0; // length of the offered prefix
+    Handle lastOffered = INVALID_HANDLE;
+
+    void withdrawOffer(Handle booking, Links & node) {
+        if (!node.offered) {
+            return;
+        }
+        node.offered = false;
+        offered--;
+        if (booking == lastOffered) {
+            lastOffered = node.prev;
+        }
+    }
+
+    void unlink(const Links & node) {
+        if (node.prev == INVALID_HANDLE) {
+            head = node.next;
+        } else {
+            links.find(node.prev) -> next = node.next;
+        }
+        if (node.next == INVALID_HANDLE) {
+            tail = node.prev;
+        } else {
+            links.find(node.next) -> prev = node.prev;
+        }
+    }
+
+    public: bool empty() const {
+        return links.empty();
+    }
+    size_t size() const {
+        return links.size();
+    }
+    Handle front() const {
+        return head;
+    }
+    size_t offeredCount() const {
+        return offered;
+    }
+
+    // Extends the offered prefix by one booking and returns it, or
+    // INVALID_HANDLE once every booking holds an offer
+    Handle offerNext() {
+        Handle booking = lastOffered == INVALID_HANDLE ? head : links.find(lastOffered) -> next;
+        if (booking != INVALID_HANDLE) {
+            links.find(booking) -> offered = true;
+            offered++;
+            lastOffered = booking;
+        }
+        return booking;
+    }
+
+    // Visits bookings in queue order
+    template < typename Visitor >
+        void forEach(Visitor visit) const {
+            for (Handle booking = head; booking != INVALID_HANDLE; booking = links.find(booking) -> next) {
+                visit(booking);
+            }
+        }
+
+    // Empties the queue and releases its storage
+    void clear() {
+        FlatHashMap < Handle, Links > ().swap(links);
+        head = tail = lastOffered = INVALID_HANDLE;
+        offered = 0;
+    }
+
+    void push(Handle booking) {
+        links.insert(booking, Links {
+            tail, INVALID_HANDLE
+        });
+        if (tail == INVALID_HANDLE) {
+            head = booking;
+        } else {
+            links.find(tail) -> next = booking;
+        }
+        tail = booking;
+    }
+
+    void pop() {
+        remove(head);
+    }
+
+    bool remove(Handle booking) {
+        Links * node = links.find(booking);
+        if (!node) {
+            return false;
+        }
+        withdrawOffer(booking, * node);
+        unlink( * node);
+        links.erase(booking);
+        return true;
+    }
+
+    bool moveToBack(Handle booking) {
+        Links * node = links.find(booking);
+        if (!node) {
+            return false;
+        }
+        withdrawOffer(booking, * node);
+        if (booking != tail) {
+            unlink( * node);
+            * node = Links {
+                tail, INVALID_HANDLE
+            };
+            links.find(tail) -> next = booking;
+            tail = booking;
+        }
+        return true;
+    }
+};
+
+// Hierarchical timer wheel with one-second ticks: LEVELS wheels of SLOTS
+// slots, level L covering deadlines up to SLOTS^(L+1) ticks ahead. A timer
+// sits in the slot of its deadline at the lowest level that can hold it and
+// is cascaded one level down when the wheel reaches that slot. Slots are
+// doubly linked lists threaded through a hash map keyed by timer id, so
+// schedule and cancel are O(1) and advancing costs O(ticks + timers due).
+class TimerWheel {
+    private: static constexpr int LEVEL_BITS = 6;
+    static constexpr int SLOTS = 1 << LEVEL_BITS;
+    static constexpr int LEVELS = 4;
+    static constexpr time_t HORIZON = time_t(1) << (LEVEL_BITS * LEVELS);
+
+    struct Node {
+        time_t deadline = 0;
+        Handle prev = INVALID_HANDLE;
+        Handle next = INVALID_HANDLE;
+        uint16_t slot = 0;
+    };
+    FlatHashMap < Handle,
+    Node > nodes; // timer id -> deadline and slot links
+    Handle heads[LEVELS * SLOTS]; // slot -> first timer
+    time_t current; // every deadline up to here has fired
+
+    // Files the timer under `when` (>= current); far-off timers park at the
+    // top level and are re-placed on cascade
+    void link(Handle id, Node & node, time_t when) {
+        when = min(when, current + HORIZON - 1);
+        time_t delta = when - current;
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= (time_t(1) << (LEVEL_BITS * (level + 1)))) {
+            level++;
+        }
+        node.slot = static_cast < uint16_t > (level * SLOTS + ((when >> (LEVEL_BITS * level)) & (SLOTS - 1)));
+        node.prev = INVALID_HANDLE;
+        node.next = heads[node.slot];
+        if (node.next != INVALID_HANDLE) {
+            nodes.find(node.next) -> prev = id;
+        }
+        heads[node.slot] = id;
+    }
+
+    void unlink(const Node & node) {
+        if (node.prev == INVALID_HANDLE) {
+            heads[node.slot] = node.next;
         } else {
-            newBooking.setStatus(BookingStatus::WAITLISTED);
-            waitlists[conferenceName].push(bookingId);
+            nodes.find(node.prev) -> next = node.next;
+        }
+        if (node.next != INVALID_HANDLE) {
+            nodes.find(node.next) -> prev = node.prev;
+        }
+    }
+
+    public: explicit TimerWheel(time_t start): current(start) {
+        fill(begin(heads), end(heads), INVALID_HANDLE);
+    }
+
+    bool empty() const {
+        return nodes.empty();
+    }
+    size_t size() const {
+        return nodes.size();
+    }
+    bool contains(Handle id) const {
+        return nodes.find(id) != nullptr;
+    }
+
+    // Adds the timer, or moves it if id is already scheduled. Deadlines that
+    // have already passed fire on the next tick.
+    void schedule(Handle id, time_t deadline) {
+        auto [node, added] = nodes.insert(id, Node());
+        if (!added) {
+            unlink( * node);
+        }
+        node -> deadline = deadline;
+        link(id, * node, max(deadline, current + 1));
+    }
+
+    bool cancel(Handle id) {
+        const Node * node = nodes.find(id);
+        if (!node) {
+            return false;
+        }
+        unlink( * node);
+        nodes.erase(id);
+        return true;
+    }
+
+    // Fires, in tick order, every timer due at or before now. visit may
+    // schedule or cancel other timers.
+    template < typename Visitor >
+        void advance(time_t now, Visitor visit) {
+            if (nodes.empty()) {
+                current = max(current, now);
+                return;
+            }
+            while (current < now) {
+                current++;
+                for (int level = 1; level < LEVELS && (current & ((time_t(1) << (LEVEL_BITS * level)) - 1)) == 0; level++) {
+                    int slot = level * SLOTS + ((current >> (LEVEL_BITS * level)) & (SLOTS - 1));
+                    for (Handle id = heads[slot]; id != INVALID_HANDLE; id = heads[slot]) {
+                        Node * node = nodes.find(id);
+                        unlink( * node);
+                        link(id, * node, node -> deadline);
+                    }
+                }
+                int slot = current & (SLOTS - 1);
+                for (Handle id = heads[slot]; id != INVALID_HANDLE; id = heads[slot]) {
+                    cancel(id);
+                    visit(id);
+                }
+            }
+        }
+};
+
+// Users holding a confirmed seat, in no particular order. A dense vector for
+// listing plus a position index, so membership, insert and swap-remove are
+// all O(1).
+class AttendeeRoster {
+    private: vector < Handle > attendees;
+    FlatHashMap < Handle,
+    Handle > positions; // user -> index in attendees
+
+    public: size_t size() const {
+        return attendees.size();
+    }
+    const vector < Handle > & getAttendees() const {
+        return attendees;
+    }
+    bool contains(Handle user) const {
+        return positions.find(user) != nullptr;
+    }
+
+    void add(Handle user) {
+        if (positions.insert(user, static_cast < Handle > (attendees.size())).second) {
+            attendees.push_back(user);
+        }
+    }
+
+    bool remove(Handle user) {
+        const Handle * position = positions.find(user);
+        if (!position) {
+            return false;
+        }
+        Handle index = * position;
+        Handle last = attendees.back();
+        attendees[index] = last;
+        * positions.find(last) = index;
+        attendees.pop_back();
+        positions.erase(user);
+        return true;
+    }
+};
+
+// Console output that can be switched off, e.g. for throughput runs where
+// every line would serialize on cout. Arguments are still evaluated.
+class Log {
+    private: bool enabled;
+
+    public: explicit Log(bool enabled): enabled(enabled) {}
+
+    template < typename T >
+        Log & operator << (const T & value) {
+            if (enabled) {
+                cout << value;
+            }
+            return * this;
+        }
+
+    Log & operator << (ostream & ( * manipulator)(ostream & )) {
+        if (enabled) {
+            cout << manipulator;
+        }
+        return * this;
+    }
+};
+
+// Reader-writer lock split into per-thread slots on separate cache lines. A
+// reader locks only its own slot, so concurrent readers never write a shared
+// line; a writer locks every slot in order. Meets the SharedMutex
+// requirements, so shared_lock and lock_guard work with it.
+class DistributedSharedMutex {
+    private: static const unsigned SLOTS = 64;
+    struct alignas(64) Slot {
+        shared_mutex lock;
+    };
+    Slot slots[SLOTS];
+
+    static unsigned slotOfThisThread() {
+        return threadSlot() % SLOTS;
+    }
+
+    public: void lock() {
+        for (Slot & slot: slots) {
+            slot.lock.lock();
+        }
+    }
+    void unlock() {
+        for (Slot & slot: slots) {
+            slot.lock.unlock();
         }
-        
-        bookings.emplace(bookingId, newBooking);
-        users.at(userId).addBooking(bookingId, newBooking.getStatus());
-        
-        return bookingId;
     }
+    void lock_shared() {
+        slots[slotOfThisThread()].lock.lock_shared();
+    }
+    void unlock_shared() {
+        slots[slotOfThisThread()].lock.unlock_shared();
+    }
+};
+
+// Locks the stripes selected by a bitmask in ascending index order, the lock
+// order within a stripe array, and unlocks them on destruction. Shared locks
+// are for readers; either mode keeps the same order.
+template < typename Stripe, bool Shared = false >
+    class StripeLock {
+        private: Stripe * stripes;
+        uint64_t mask;
+
+        public: StripeLock(Stripe * stripes, uint64_t mask): stripes(stripes), mask(mask) {
+            for (uint64_t rest = mask; rest != 0; rest &= rest - 1) {
+                if constexpr (Shared) {
+                    stripes[countr_zero(rest)].lock.lock_shared();
+                } else {
+                    stripes[countr_zero(rest)].lock.lock();
+                }
+            }
+        }
+
+        ~StripeLock() {
+            for (uint64_t rest = mask; rest != 0; rest &= rest - 1) {
+                if constexpr (Shared) {
+                    stripes[countr_zero(rest)].lock.unlock_shared();
+                } else {
+                    stripes[countr_zero(rest)].lock.unlock();
+                }
+            }
+        }
+
+        StripeLock(const StripeLock & ) = delete;
+        StripeLock & operator = (const StripeLock & ) = delete;
+    };
+
+template < typename Stripe >
+    using SharedStripeLock = StripeLock < Stripe, true > ;
 
+class ConferenceBookingSystem {
+    private: SymbolTable topicIds; // topic -> bit in TopicMask
+    FlatHashMap < string,
+    vector < Handle >> pendingInterests; // topic no conference covers yet -> interested users
+    SymbolTable conferenceIds; // name -> conference handle
+    ConferenceStore conferences; // conference handle -> Conference
+    SymbolTable userIds; // userId -> user handle
+    vector < User > users; // user handle -> User
+    BookingIdGenerator bookingIdGenerator;
+    vector < Waitlist > waitlists; // conference handle -> queue of bookings
+    vector < AttendeeRoster > rosters; // conference handle -> confirmed users
+    CalendarIndex calendar; // start hour -> conferences, for window and overlap queries
+    TopicIndex topicIndex; // topic -> conferences ordered by start time
+    VenueIndex venues; // location -> conferences ordered by start time
+
+    // Conferences are striped by handle, and a booking lives in its
+    // conference's stripe (which is also its id's generator shard), so one
+    // stripe lock covers the seats, waitlists, rosters and offers of its
+    // conferences together with the bookings made for them. A booking
+    // handle is (slot in the stripe's pool) * LOCK_STRIPES + stripe.
+    // Stripe locks are reader-writer locks: status, roster and
+    // recommendation queries share them, anything that changes a stripe
+    // holds it exclusively.
+    static const unsigned LOCK_STRIPES = BookingIdGenerator::NUM_SHARDS;
+    static const uint64_t ALL_STRIPES = ~uint64_t(0);
+    struct alignas(64) ConferenceStripe {
+        mutable shared_mutex lock;
+        SlabPool < Booking > bookings; // pool slot -> Booking
+        FlatHashMap < BookingId,
+        Handle > bookingHandles; // bookingId -> booking handle
+        vector < Handle > canceledBookings; // canceled, not yet archived
+        FlatHashMap < BookingId,
+        BookingStatus > archivedBookings; // bookingId -> final status, append-only
+        TimerWheel offers {
+            time(nullptr)
+        }; // waitlisted bookings offered a freed slot, by deadline
+    };
+    // Users are striped by handle; a user's stripe guards its User record
+    struct alignas(64) UserStripe {
+        mutable shared_mutex lock;
+    };
+    ConferenceStripe stripes[LOCK_STRIPES];
+    UserStripe userStripes[LOCK_STRIPES];
+
+    // Lock order: sweep_mutex, catalog_mutex, user stripes, conference
+    // stripes, each stripe array in ascending index. catalog_mutex is held
+    // exclusively only to add conferences and users, which grows the tables
+    // every other operation indexes into.
+    mutable DistributedSharedMutex catalog_mutex;
+    mutex sweep_mutex; // serializes the start and end sweeps
+    time_t endedSweptUntil = 0; // conferences ending before this are archived
+    time_t startedSweptUntil = 0; // conferences starting before this have no waitlist
+    atomic < bool > logging {
+        true
+    };
+    Log log() const {
+        return Log(logging.load(memory_order_relaxed));
+    }
+    atomic < time_t > offerWindow {
+        3600
+    }; // seconds a waitlist offer stays open
+
+    // Background maintenance (compaction)
+    thread maintenanceThread;
+    mutex maintenance_mutex;
+    condition_variable maintenanceWake;
+    bool maintenanceStopping = false;
 
     public:
-        // Conference management
+        // Conference management. Up to 10 topics per conference; the catalog
+        // takes any number of distinct topics, though past TOPIC_MASK_BITS
+        // of them recommendation scores become approximate.
         void addConference(const string & name,
             const string & location,
                 const vector < string > & topics,
                     const Timestamp & start,
                         const Timestamp & end, int slots);
 
-    // User management
+    // User management. Up to 50 interests per user.
     void addUser(const string & userId,
         const vector < string > & topics);
 
-    // Booking operations
+    // Console logging of booking operations, on by default
+    void setLogging(bool enabled) {
+        logging.store(enabled, memory_order_relaxed);
+    }
+
+    // How long a waitlisted user has to confirm an offered slot, one hour by
+    // default; applies to offers made from then on
+    void setOfferWindow(chrono::seconds window) {
+        offerWindow.store(window.count(), memory_order_relaxed);
+    }
+
+    // Booking operations; all are safe to call concurrently
     string bookConference(const string & userId,
         const string & conferenceName);
+    // Takes up the slot offered to the booking. False once the offer has
+    // lapsed, which sends the booking to the back of the queue; throws if
+    // no slot has been offered yet.
     bool confirmWaitlistedBooking(const string & bookingId);
     bool cancelBooking(const string & bookingId);
     BookingStatus getBookingStatus(const string & bookingId) const;
 
-    private: void processWaitlist(const string & conferenceName);
-    string generateBookingId() const;
-    void validateConferenceExists(const string & name) const;
-    void validateUserExists(const string & userId) const;
-    void setWaitlistConfirmationDeadline(Booking & booking) {
+    // Expires waitlist offers whose deadline has passed: each booking goes to
+    // the back of its waitlist and the slot is offered to the next in line.
+    // Returns the number expired.
+    size_t expireWaitlistOffers();
+
+    // Cancels the waitlists of conferences that have started since the last
+    // sweep. Returns the number of bookings canceled.
+    size_t releaseStartedWaitlists();
+
+    // Moves canceled bookings, and bookings of conferences that have ended,
+    // out of the live tables into the archive, where getBookingStatus still
+    // finds them. Their records are reused by later bookings. Returns the
+    // number archived.
+    size_t compactBookings();
+
+    // Background thread that expires waitlist offers and releases the
+    // waitlists of started conferences every second, and runs compactBookings
+    // every compactionInterval, until stopMaintenance() or destruction
+    void startMaintenance(chrono::milliseconds compactionInterval);
+    void stopMaintenance();
+    ~ConferenceBookingSystem();
+
+    // Catalog queries
+    vector < string > getConferencesOverlapping(const Timestamp & start,
+        const Timestamp & end) const;
+
+    // Conferences starting in [from, to) with at least minFreeSlots open, in
+    // start order, pageSize (at least 1) at a time. Pass the previous page's
+    // nextCursor to continue; it is empty once there are no more results.
+    struct ConferencePage {
+        vector < string > conferences;
+        string nextCursor;
+    };
+    ConferencePage findConferencesStartingBetween(const Timestamp & from,
+        const Timestamp & to, int minFreeSlots, size_t pageSize,
+            const string & cursor = "") const;
+
+    // Catalog-wide aggregates, computed by column scans
+    long long getTotalAvailableSeats() const;
+    size_t countConferencesStartingBetween(const Timestamp & from,
+        const Timestamp & to) const;
+    size_t countSoldOutConferences() const;
+
+    // Venue queries, each reading only that location's conferences
+    struct VenueOccupancy {
+        int bookedSeats;
+        int totalSeats;
+    };
+    vector < string > getUpcomingConferencesAtVenue(const string & location) const;
+    int getVenueRemainingCapacity(const string & location) const;
+    VenueOccupancy getVenueOccupancy(const string & location,
+        const Timestamp & start,
+            const Timestamp & end) const;
+
+    // Upcoming conferences, ordered by start time, covering all (matchAll)
+    // or any of the given topics
+    vector < string > findConferencesByTopics(const vector < string > & topics,
+        bool matchAll) const;
+
+    // Roster of confirmed attendees
+    vector < string > getConferenceAttendees(const string & conferenceName) const;
+    size_t getAttendeeCount(const string & conferenceName) const;
+    bool isAttending(const string & userId,
+        const string & conferenceName) const;
+
+    // Recommendations: upcoming conferences with free slots that fit the
+    // user's confirmed schedule, best topic overlap first
+    vector < string > recommendConferences(const string & userId, size_t k) const;
+    vector < pair < string,
+    vector < string >>> recommendConferencesForAllUsers(size_t k,
+        unsigned threadCount = thread::hardware_concurrency()) const;
+
+    private: void processWaitlist(Handle conference);
+    BookingId generateBookingId(Handle conference);
+    Handle resolveConference(const string & name) const;
+    Handle resolveUser(const string & userId) const;
+    Handle resolveBooking(const string & bookingId) const;
+    Booking snapshotBooking(const string & bookingId, bool confirming) const;
+    void rejectArchivedBooking(const string & bookingId, bool confirming) const;
+    const VenueIndex::Schedule & resolveVenue(const string & location) const;
+    TopicMask internTopics(const vector < string > & topics, vector < Handle > & handles);
+    TopicMask userTopics(const vector < string > & topics, Handle user);
+    vector < Handle > topRecommendations(Handle user, size_t k, time_t now,
+        vector < uint8_t > & scores) const;
+    // Conference and booking handles share the stripe mapping
+    static uint64_t stripeBit(Handle handle) {
+        return uint64_t(1) << (handle % LOCK_STRIPES);
+    }
+    ConferenceStripe & stripeOf(Handle handle) {
+        return stripes[handle % LOCK_STRIPES];
+    }
+    const ConferenceStripe & stripeOf(Handle handle) const {
+        return stripes[handle % LOCK_STRIPES];
+    }
+    Booking & bookingAt(Handle booking) {
+        return stripeOf(booking).bookings[booking / LOCK_STRIPES];
+    }
+    const Booking & bookingAt(Handle booking) const {
+        return stripeOf(booking).bookings[booking / LOCK_STRIPES];
+    }
+    uint64_t stripesForBooking(Handle user, Handle conference) const;
+    Handle storeBooking(const Booking & booking) {
+        ConferenceStripe & stripe = stripeOf(booking.getConference());
+        Handle handle = stripe.bookings.allocate(booking) * LOCK_STRIPES + booking.getConference() % LOCK_STRIPES;
+        stripe.bookingHandles.insert(booking.getId(), handle);
+        return handle;
+    }
+    void archiveBooking(Handle bookingHandle) {
+        ConferenceStripe & stripe = stripeOf(bookingHandle);
+        const Booking & booking = bookingAt(bookingHandle);
+        stripe.archivedBookings.insert(booking.getId(), booking.getStatus());
+        stripe.bookingHandles.erase(booking.getId());
+        stripe.bookings.release(bookingHandle / LOCK_STRIPES);
+    }
+    bool archiveEndedBookings(unsigned stripe, Handle & next, time_t now);
+    bool hasConferenceEndedSince(time_t since, time_t now) const;
+    string bookingIdOf(Handle booking) const {
+        return BookingIdGenerator::encode(bookingAt(booking).getId());
+    }
+    void setWaitlistConfirmationDeadline(Handle bookingHandle) {
         Timestamp deadline {
-            time(nullptr) + 3600
-        }; // 1 hour from now
-        booking.setConfirmationDeadline(deadline);
-        cout << "Set confirmation deadline to: " << ctime( & deadline.time);
+            time(nullptr) + offerWindow.load(memory_order_relaxed)
+        };
+        bookingAt(bookingHandle).setConfirmationDeadline(deadline);
+        // Confirmable through the deadline second, so the timer fires after it
+        stripeOf(bookingHandle).offers.schedule(bookingHandle, deadline.time + 1);
+        char text[26]; // ctime_r: stripes run concurrently, ctime's buffer is shared
+        log() << "Set confirmation deadline to: " << ctime_r( & deadline.time, text);
+    }
+    // Ends the booking's offer, if it has one, once the booking has left the
+    // front of its queue; the seat the offer held goes to the next in line
+    void withdrawOffer(Handle bookingHandle) {
+        if (stripeOf(bookingHandle).offers.cancel(bookingHandle)) {
+            processWaitlist(bookingAt(bookingHandle).getConference());
+        }
     }
-    bool hasConflictingBooking(const string & userId,
+    // Confirming a waitlisted booking keeps its id, so only creation and
+    // cancellation touch the index.
+    void indexActiveBooking(Handle booking) {
+        users[bookingAt(booking).getUser()].setActiveBooking(bookingAt(booking).getConference(), booking);
+    }
+    void unindexActiveBooking(Handle booking) {
+        users[bookingAt(booking).getUser()].clearActiveBooking(bookingAt(booking).getConference());
+    }
+    bool hasConflictingBooking(Handle userHandle,
         const Conference & newConference) {
-        cout << "Checking for conflicting bookings for user: " << userId << endl;
+        const User & user = users[userHandle];
+        log() << "Checking for conflicting bookings for user: " << user.getUserId() << endl;
+
+        Handle conflicting = user.findConflictingWindow(newConference.getStartTime(),
+            newConference.getEndTime());
+        if (conflicting != INVALID_HANDLE) {
+            log() << "Found conflicting booking: " << bookingIdOf(conflicting) << endl;
+            return true;
+        }
+        return false;
+    }
 
-        const User & user = users.at(userId);
-        auto activeBookings = user.getActiveBookings();
+    void removeFromOverlappingWaitlists(Handle userHandle, Handle bookedConference) {
+        log() << "Removing user from overlapping conference waitlists" << endl;
+
+        // Only the user's own waitlisted bookings can be affected
+        const Conference & bookedConf = conferences[bookedConference];
+        User & user = users[userHandle];
+        vector < Handle > overlappingEntries;
+        user.getWaitlistedBookings().forEach([ & ](Handle booking, Handle conference) {
+            if (conference != bookedConference &&
+                conferences[conference].isTimeOverlapping(bookedConf.getStartTime(), bookedConf.getEndTime())) {
+                overlappingEntries.push_back(booking);
+            }
+        });
 
-        for (const string & bookingId: activeBookings) {
-            const Booking & booking = bookings.at(bookingId);
-            if (booking.getStatus() == BookingStatus::CANCELED) continue;
-            if (booking.getStatus() != BookingStatus::CONFIRMED) continue;
+        for (Handle bookingHandle: overlappingEntries) {
+            Booking & booking = bookingAt(bookingHandle);
+            waitlists[booking.getConference()].remove(bookingHandle);
 
-            const Conference & existingConf = conferences.at(booking.getConferenceName());
-            if (existingConf.isTimeOverlapping(newConference.getStartTime(),
-                    newConference.getEndTime())) {
-                cout << "Found conflicting booking: " << bookingId << endl;
-                return true;
-            }
+            // Cancel the waitlisted booking
+            booking.setStatus(BookingStatus::CANCELED);
+            unindexActiveBooking(bookingHandle);
+            user.removeWaitlistedBooking(bookingHandle);
+            stripeOf(bookingHandle).canceledBookings.push_back(bookingHandle);
+            log() << "Canceled overlapping waitlisted booking: " << bookingIdOf(bookingHandle) << endl;
+            withdrawOffer(bookingHandle);
         }
-        return false;
     }
 
-    void removeFromOverlappingWaitlists(const string & userId,
-        const Conference & bookedConf) {
-        cout << "Removing user from overlapping conference waitlists" << endl;
+    // Cancels the whole waitlist in one pass and frees the queue's storage.
+    // Logs one line for the conference, not one per booking.
+    size_t cancelAllWaitlistedBookings(Handle conference) {
+        auto & waitlist = waitlists[conference];
+        size_t canceled = waitlist.size();
+        if (canceled == 0) {
+            return 0;
+        }
+        ConferenceStripe & stripe = stripeOf(conference);
+        waitlist.forEach([ & ](Handle bookingHandle) {
+            if (stripe.offers.cancel(bookingHandle)) {
+                conferences[conference].increaseAvailableSlots();
+            }
+            auto & booking = bookingAt(bookingHandle);
+            booking.setStatus(BookingStatus::CANCELED);
+            unindexActiveBooking(bookingHandle);
+            users[booking.getUser()].removeWaitlistedBooking(bookingHandle);
+            stripe.canceledBookings.push_back(bookingHandle);
+        });
+        waitlist.clear();
+        log() << "Canceled " << canceled << " waitlisted bookings for conference: " << conferences[conference].getName() << endl;
+        return canceled;
+    }
+
+};
+
+bool ConferenceBookingSystem::cancelBooking(const string & bookingId) {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+
+    log() << "Attempting to cancel booking: " << bookingId << endl;
+
+    // A booking's user and conference never change, so the snapshot says
+    // which locks to take; the booking is then resolved again under them
+    Booking snapshot = snapshotBooking(bookingId, false);
+    StripeLock<const UserStripe> user_lock(userStripes, stripeBit(snapshot.getUser()));
+    StripeLock<const ConferenceStripe> conference_lock(stripes, stripeBit(snapshot.getConference()));
+    rejectArchivedBooking(bookingId, false);
+    Handle bookingHandle = resolveBooking(bookingId);
+    Booking & booking = bookingAt(bookingHandle);
+    if (booking.getStatus() == BookingStatus::CANCELED) {
+        throw runtime_error("Booking is already canceled");
+    }
+
+    // Check if conference has started
+    Conference conference = conferences[booking.getConference()];
+    if (conference.hasStarted()) {
+        throw runtime_error("Cannot cancel booking after conference has started");
+    }
+
+    // If it was a confirmed booking, increase available slots
+    if (booking.getStatus() == BookingStatus::CONFIRMED) {
+        rosters[booking.getConference()].remove(booking.getUser());
+        users[booking.getUser()].removeConfirmedWindow(conference.getStartTime());
+
+        // The seat goes to the waitlist, or back to the pool
+        processWaitlist(booking.getConference());
+        log() << "Slot freed up. Available slots: " << conference.getAvailableSlots() << endl;
+    } else if (booking.getStatus() == BookingStatus::WAITLISTED) {
+        // Remove from waitlist queue; a withdrawn offer passes to the next
+        waitlists[booking.getConference()].remove(bookingHandle);
+        log() << "Removed from waitlist" << endl;
+        withdrawOffer(bookingHandle);
+    }
+
+    booking.setStatus(BookingStatus::CANCELED);
+    unindexActiveBooking(bookingHandle);
+    users[booking.getUser()].removeWaitlistedBooking(bookingHandle);
+    stripeOf(bookingHandle).canceledBookings.push_back(bookingHandle);
+    log() << "Booking canceled successfully" << endl;
+    return true;
+}
+
+// An offer holds its seat until it is taken up or returns it. Run under the
+// conference's stripe with the seat of a canceled booking or of an offer
+// that was withdrawn, expired or declined: it goes straight to the first
+// waitlisted booking without an offer, in queue order. The seat never passes
+// through the counter, so a booking made outside the lock cannot take it
+// first; it goes back to the counter only when nobody is waiting for one.
+void ConferenceBookingSystem::processWaitlist(Handle conference) {
+    log() << "Processing waitlist for conference: " << conferences[conference].getName() << endl;
+
+    // A started conference's queue is about to be released
+    Conference conf = conferences[conference];
+    Handle bookingHandle = conf.hasStarted() ? INVALID_HANDLE : waitlists[conference].offerNext();
+    if (bookingHandle == INVALID_HANDLE) {
+        log() << "No users in waitlist" << endl;
+        conf.increaseAvailableSlots();
+        return;
+    }
+
+    // Set confirmation deadline
+    setWaitlistConfirmationDeadline(bookingHandle);
+    log() << "Notifying user " << users[bookingAt(bookingHandle).getUser()].getUserId() << " about available slot" << endl;
+}
+
+void ConferenceBookingSystem::addConference(const string & name,
+    const string & location,
+        const vector < string > & topics,
+            const Timestamp & start,
+                const Timestamp & end, int slots) {
+    lock_guard<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    if (conferenceIds.find(name) != INVALID_HANDLE) {
+        throw runtime_error("Conference with this name already exists");
+    }
+
+    ConferenceStore::validate(countDistinct(topics), start, end, slots);
+    vector < Handle > topicHandles;
+    TopicMask topicMask = internTopics(topics, topicHandles);
+    Handle handle = conferences.add(name, location, topicMask, start, end, slots);
+    conferenceIds.intern(name);
+    waitlists.emplace_back();
+    rosters.emplace_back();
+    calendar.add(handle, start, end);
+    topicIndex.add(handle, start.time, topicHandles);
+    venues.add(handle, location, start.time);
+}
+
+long long ConferenceBookingSystem::getTotalAvailableSeats() const {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    return conferences.totalAvailableSlots();
+}
+
+size_t ConferenceBookingSystem::countConferencesStartingBetween(const Timestamp & from,
+    const Timestamp & to) const {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    return conferences.countStartingBetween(from.time, to.time);
+}
 
-        vector < string > conferencesToUpdate;
+size_t ConferenceBookingSystem::countSoldOutConferences() const {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    return conferences.countSoldOut();
+}
 
-        // Find all overlapping conferences
-        for (const auto & [confName, conf]: conferences) {
-            if (confName != bookedConf.getName() &&
-                conf.isTimeOverlapping(bookedConf.getStartTime(), bookedConf.getEndTime())) {
-                conferencesToUpdate.push_back(confName);
-            }
-        }
+vector < string > ConferenceBookingSystem::getUpcomingConferencesAtVenue(const string & location) const {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    const auto & schedule = resolveVenue(location);
+    vector < string > result;
+    schedule.forEachAfter(time(nullptr), [ & ](const VenueIndex::Schedule::Entry & entry) {
+        result.push_back(conferences[entry.second].getName());
+        return true;
+    });
+    return result;
+}
 
-        // Remove from their waitlists
-        for (const string & confName: conferencesToUpdate) {
-            auto & waitlist = waitlists[confName];
-            queue < string > updatedQueue;
+// Open seats across the venue's conferences that have not started yet
+int ConferenceBookingSystem::getVenueRemainingCapacity(const string & location) const {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    const auto & schedule = resolveVenue(location);
+    int remaining = 0;
+    schedule.forEachAfter(time(nullptr), [ & ](const VenueIndex::Schedule::Entry & entry) {
+        remaining += conferences[entry.second].getAvailableSlots();
+        return true;
+    });
+    return remaining;
+}
 
-            while (!waitlist.empty()) {
-                string bookingId = waitlist.front();
-                waitlist.pop();
+// Booked and total seats of the venue's conferences overlapping [start, end)
+ConferenceBookingSystem::VenueOccupancy ConferenceBookingSystem::getVenueOccupancy(const string & location,
+    const Timestamp & start,
+        const Timestamp & end) const {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    const auto & schedule = resolveVenue(location);
+    VenueOccupancy occupancy {
+        0, 0
+    };
+    schedule.forEachAfter(start.time - MAX_CONFERENCE_DURATION, [ & ](const VenueIndex::Schedule::Entry & entry) {
+        if (entry.first >= end.time) {
+            return false;
+        }
+        const Conference & conference = conferences[entry.second];
+        if (conference.isTimeOverlapping(start, end)) {
+            occupancy.bookedSeats += conference.getTotalSlots() - conference.getAvailableSlots();
+            occupancy.totalSeats += conference.getTotalSlots();
+        }
+        return true;
+    });
+    return occupancy;
+}
 
-                const Booking & booking = bookings.at(bookingId);
-                if (booking.getUserId() != userId) {
-                    updatedQueue.push(bookingId);
-                } else {
-                    // Cancel the waitlisted booking
-                    bookings.at(bookingId).setStatus(BookingStatus::CANCELED);
-                    cout << "Canceled overlapping waitlisted booking: " << bookingId << endl;
-                }
-            }
+// The cursor is the name of the last conference returned, which pins down
+// its (start, handle) position in the calendar.
+ConferenceBookingSystem::ConferencePage ConferenceBookingSystem::findConferencesStartingBetween(const Timestamp & from,
+    const Timestamp & to, int minFreeSlots, size_t pageSize,
+        const string & cursor) const {
+    if (pageSize == 0) {
+        throw runtime_error("Page size must be greater than 0");
+    }
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    CalendarIndex::Cursor after {};
+    if (!cursor.empty()) {
+        after.conference = resolveConference(cursor);
+        after.start = conferences[after.conference].getStartTime().time;
+    }
 
-            waitlists[confName] = updatedQueue;
+    ConferencePage page;
+    Handle last = INVALID_HANDLE;
+    bool more = false;
+    calendar.forEachStarting(from.time, to.time, cursor.empty() ? nullptr : & after, [ & ](Handle conference) {
+        if (conferences[conference].getAvailableSlots() < minFreeSlots) {
+            return true;
         }
+        if (page.conferences.size() == pageSize) {
+            more = true;
+            return false;
+        }
+        page.conferences.push_back(conferences[conference].getName());
+        last = conference;
+        return true;
+    });
+    if (more) {
+        page.nextCursor = conferences[last].getName();
     }
+    return page;
+}
 
-    void cancelAllWaitlistedBookings(const string & conferenceName) {
-        cout << "Canceling all waitlisted bookings for conference: " << conferenceName << endl;
-
-        auto & waitlist = waitlists[conferenceName];
-        while (!waitlist.empty()) {
-            string bookingId = waitlist.front();
-            waitlist.pop();
-
-            auto & booking = bookings.at(bookingId);
-            booking.setStatus(BookingStatus::CANCELED);
-            cout << "Canceled waitlisted booking: " << bookingId << endl;
+vector < string > ConferenceBookingSystem::findConferencesByTopics(const vector < string > & topics,
+    bool matchAll) const {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    vector < Handle > topicHandles;
+    for (const string & topic: topics) {
+        Handle handle = topicIds.find(topic);
+        if (handle == INVALID_HANDLE && matchAll) {
+            return {};
+        }
+        if (handle != INVALID_HANDLE) {
+            topicHandles.push_back(handle);
         }
     }
 
-};
-
-bool ConferenceBookingSystem::cancelBooking(const string & bookingId) {
-    lock_guard<mutex> conf_lock(conference_mutex);
-    lock_guard<mutex> book_lock(booking_mutex);
-    lock_guard<mutex> wait_lock(waitlist_mutex);
+    time_t now = time(nullptr);
+    vector < string > result;
+    for (Handle conference: matchAll ? topicIndex.findAll(topicHandles, now) : topicIndex.findAny(topicHandles, now)) {
+        result.push_back(conferences[conference].getName());
+    }
+    return result;
+}
 
-    cout << "Attempting to cancel booking: " << bookingId << endl;
+vector < string > ConferenceBookingSystem::getConferencesOverlapping(const Timestamp & start,
+    const Timestamp & end) const {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    vector < string > result;
+    calendar.forEachOverlapping(start, end, [ & ](Handle conference) {
+        result.push_back(conferences[conference].getName());
+    });
+    return result;
+}
 
-    auto bookingIt = bookings.find(bookingId);
-    if (bookingIt == bookings.end()) {
-        throw runtime_error("Booking not found");
+// Scores the whole catalog in one pass, then keeps the k best candidates in a
+// min-heap. The availability and calendar filters run only for conferences
+// that would enter the heap.
+vector < Handle > ConferenceBookingSystem::topRecommendations(Handle userHandle, size_t k, time_t now,
+    vector < uint8_t > & scores) const {
+    const User & user = users[userHandle];
+    const vector < TopicMask > & topics = conferences.getTopicColumn();
+    scores.resize(topics.size());
+    scoreTopicOverlap(topics.data(), topics.size(), user.getInterestedTopics(), scores.data());
+
+    // Higher score first, then earlier start
+    auto better = [ & ](Handle a, Handle b) {
+        if (scores[a] != scores[b]) {
+            return scores[a] > scores[b];
+        }
+        return conferences[a].getStartTime().time < conferences[b].getStartTime().time;
+    };
+    vector < Handle > heap;
+    if (k == 0) {
+        return heap;
     }
-
-    Booking & booking = bookingIt -> second;
-    if (booking.getStatus() == BookingStatus::CANCELED) {
-        throw runtime_error("Booking is already canceled");
+    for (Handle conference = 0; conference < scores.size(); conference++) {
+        if (scores[conference] == 0 || (heap.size() == k && !better(conference, heap.front()))) {
+            continue;
+        }
+        const Conference & conf = conferences[conference];
+        if (conf.getStartTime().time <= now || !conf.hasSlotAvailable() ||
+            user.findActiveBooking(conference) != INVALID_HANDLE ||
+            user.findConflictingWindow(conf.getStartTime(), conf.getEndTime()) != INVALID_HANDLE) {
+            continue;
+        }
+        heap.push_back(conference);
+        push_heap(heap.begin(), heap.end(), better);
+        if (heap.size() > k) {
+            pop_heap(heap.begin(), heap.end(), better);
+            heap.pop_back();
+        }
     }
+    sort_heap(heap.begin(), heap.end(), better);
+    return heap;
+}
 
-    // Check if conference has started
-    Conference & conference = conferences.at(booking.getConferenceName());
-    if (conference.hasStarted()) {
-        throw runtime_error("Cannot cancel booking after conference has started");
+vector < string > ConferenceBookingSystem::recommendConferences(const string & userId, size_t k) const {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    Handle userHandle = resolveUser(userId);
+    SharedStripeLock<const UserStripe> user_lock(userStripes, stripeBit(userHandle));
+
+    vector < uint8_t > scores;
+    vector < string > result;
+    for (Handle conference: topRecommendations(userHandle, k, time(nullptr), scores)) {
+        result.push_back(conferences[conference].getName());
     }
+    return result;
+}
 
-    // If it was a confirmed booking, increase available slots
-    if (booking.getStatus() == BookingStatus::CONFIRMED) {
-        conference.increaseAvailableSlots();
-        cout << "Slot freed up. Available slots: " << conference.getAvailableSlots() << endl;
+// Users are split across threadCount workers; each keeps its own score
+// buffer and writes only its own users' result slots. The batch covers the
+// users registered when it starts. Locks are taken per user, so a booking
+// or a new user waits for one user's scoring, not for the whole batch.
+vector < pair < string,
+vector < string >>> ConferenceBookingSystem::recommendConferencesForAllUsers(size_t k,
+    unsigned threadCount) const {
+    size_t userCount;
+    {
+        shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+        userCount = users.size();
+    }
 
-        // Process waitlist if any
-        processWaitlist(booking.getConferenceName());
-    } else if (booking.getStatus() == BookingStatus::WAITLISTED) {
-        // Remove from waitlist queue
-        auto & waitlist = waitlists[booking.getConferenceName()];
-        queue < string > updatedQueue;
-        while (!waitlist.empty()) {
-            string currentId = waitlist.front();
-            waitlist.pop();
-            if (currentId != bookingId) {
-                updatedQueue.push(currentId);
+    time_t now = time(nullptr);
+    vector < pair < string, vector < string >>> result(userCount);
+    threadCount = max(1u, min < unsigned > (threadCount, userCount));
+    vector < thread > workers;
+    for (unsigned worker = 0; worker < threadCount; worker++) {
+        workers.emplace_back([ & , worker]() {
+            vector < uint8_t > scores;
+            for (Handle user = worker; user < userCount; user += threadCount) {
+                shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+                SharedStripeLock<const UserStripe> user_lock(userStripes, stripeBit(user));
+                result[user].first = users[user].getUserId();
+                for (Handle conference: topRecommendations(user, k, now, scores)) {
+                    result[user].second.push_back(conferences[conference].getName());
+                }
             }
-        }
-        waitlists[booking.getConferenceName()] = updatedQueue;
-        cout << "Removed from waitlist" << endl;
+        });
     }
-
-    booking.setStatus(BookingStatus::CANCELED);
-    users.at(booking.getUserId()).removeBooking(bookingId);
-    cout << "Booking canceled successfully" << endl;
-    return true;
+    for (auto & worker: workers) {
+        worker.join();
+    }
+    return result;
 }
 
-void ConferenceBookingSystem::processWaitlist(const string & conferenceName) {
-    cout << "Processing waitlist for conference: " << conferenceName << endl;
+vector < string > ConferenceBookingSystem::getConferenceAttendees(const string & conferenceName) const {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    Handle conference = resolveConference(conferenceName);
+    SharedStripeLock<const ConferenceStripe> conference_lock(stripes, stripeBit(conference));
 
-    auto & waitlist = waitlists[conferenceName];
-    if (waitlist.empty()) {
-        cout << "No users in waitlist" << endl;
-        return;
+    const AttendeeRoster & roster = rosters[conference];
+    vector < string > result;
+    result.reserve(roster.size());
+    for (Handle user: roster.getAttendees()) {
+        result.push_back(users[user].getUserId());
     }
+    return result;
+}
 
-    // Get next waitlisted booking
-    string nextBookingId = waitlist.front();
-    auto & booking = bookings.at(nextBookingId);
+size_t ConferenceBookingSystem::getAttendeeCount(const string & conferenceName) const {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    Handle conference = resolveConference(conferenceName);
+    SharedStripeLock<const ConferenceStripe> conference_lock(stripes, stripeBit(conference));
 
-    // Set confirmation deadline
-    setWaitlistConfirmationDeadline(booking);
-    cout << "Notifying user " << booking.getUserId() << " about available slot" << endl;
+    return rosters[conference].size();
 }
 
-void ConferenceBookingSystem::addConference(const string & name,
-    const string & location,
-        const vector < string > & topics,
-            const Timestamp & start,
-                const Timestamp & end, int slots) {
-    if (conferences.find(name) != conferences.end()) {
-        throw runtime_error("Conference with this name already exists");
-    }
+bool ConferenceBookingSystem::isAttending(const string & userId,
+    const string & conferenceName) const {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    Handle conference = resolveConference(conferenceName);
+    Handle user = resolveUser(userId);
+    SharedStripeLock<const ConferenceStripe> conference_lock(stripes, stripeBit(conference));
 
-    conferences.emplace(name, Conference(name, location, topics, start, end, slots));
+    return rosters[conference].contains(user);
 }
 
 void ConferenceBookingSystem::addUser(const string & userId,
     const vector < string > & topics) {
-    if (users.find(userId) != users.end()) {
+    lock_guard<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    if (userIds.find(userId) != INVALID_HANDLE) {
         throw runtime_error("User already exists");
     }
 
-    users.emplace(userId, User(userId, topics));
+    User::validateTopicCount(countDistinct(topics));
+    User user(userId, userTopics(topics, static_cast < Handle > (users.size())));
+    userIds.intern(userId);
+    users.push_back(user);
 }
 
 string ConferenceBookingSystem::bookConference(const string & userId,
     const string & conferenceName) {
-    cout << "Attempting to book conference: " << conferenceName << " for user: " << userId << endl;
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    log() << "Attempting to book conference: " << conferenceName << " for user: " << userId << endl;
 
-    validateUserExists(userId);
-    validateConferenceExists(conferenceName);
+    Handle userHandle = resolveUser(userId);
+    Handle conferenceHandle = resolveConference(conferenceName);
 
     // Check if conference has started
-    auto & conference = conferences.at(conferenceName);
+    Conference conference = conferences[conferenceHandle];
     if (conference.hasStarted()) {
         throw runtime_error("Cannot book conference that has already started");
     }
 
-    // Check for existing booking
-    for (const auto & [id, booking]: bookings) {
-        if (booking.getUserId() == userId &&
-            booking.getConferenceName() == conferenceName &&
-            booking.getStatus() != BookingStatus::CANCELED) {
-            throw runtime_error("User already has an active booking for this conference with ID: " + id);
+    // Only this user's stripe and the stripes this booking can touch are
+    // locked, so bookings for other users and other conferences proceed
+    // in parallel
+    StripeLock<const UserStripe> user_lock(userStripes, stripeBit(userHandle));
+
+    // Take the seat before the conference stripes, keeping the counter
+    // update out of the stripe's critical section. Only a booking that can
+    // go ahead reserves one.
+    Handle active = users[userHandle].findActiveBooking(conferenceHandle);
+    bool seated = active == INVALID_HANDLE &&
+        users[userHandle].findConflictingWindow(conference.getStartTime(), conference.getEndTime()) == INVALID_HANDLE &&
+        conference.decreaseAvailableSlots();
+
+    StripeLock<const ConferenceStripe> conference_lock(stripes, stripesForBooking(userHandle, conferenceHandle));
+
+    // The start sweep needs every user stripe, so with this user's held it
+    // cannot run: once the conference is seen not started here, the sweep
+    // that releases its waitlist is still to come
+    if (conference.hasStarted()) {
+        if (seated) {
+            conference.increaseAvailableSlots();
         }
+        throw runtime_error("Cannot book conference that has already started");
+    }
+
+    // Check for existing booking
+    if (active != INVALID_HANDLE) {
+        throw runtime_error("User already has an active booking for this conference with ID: " + bookingIdOf(active));
     }
 
     // Check for conflicts
-    if (hasConflictingBooking(userId, conference)) {
+    if (hasConflictingBooking(userHandle, conference)) {
         throw runtime_error("User has a conflicting booking");
     }
 
     // Create booking
-    Booking newBooking(userId, conferenceName);
-    string bookingId = newBooking.getBookingId();
-
-    // Try to get a slot
-    if (conference.decreaseAvailableSlots()) {
-        cout << "Slot available. Creating confirmed booking." << endl;
+    Booking newBooking(generateBookingId(conferenceHandle), userHandle, conferenceHandle);
+    string bookingId = BookingIdGenerator::encode(newBooking.getId());
+
+    // Try to get a slot. Seats are only given back under the conference's
+    // stripe lock, so a second try here cannot miss a seat freed meanwhile.
+    // A seat freed while anyone is queued passes straight to the queue and
+    // never reaches the counter, so taking one from it jumps nobody.
+    if (seated || conference.decreaseAvailableSlots()) {
+        log() << "Slot available. Creating confirmed booking." << endl;
         newBooking.setStatus(BookingStatus::CONFIRMED);
-        // Remove from overlapping waitlists
-        removeFromOverlappingWaitlists(userId, conference);
     } else {
-        cout << "No slots available. Adding to waitlist." << endl;
+        log() << "No slots available. Adding to waitlist." << endl;
         newBooking.setStatus(BookingStatus::WAITLISTED);
+    }
+
+    Handle bookingHandle = storeBooking(newBooking);
+    if (newBooking.getStatus() == BookingStatus::CONFIRMED) {
+        rosters[conferenceHandle].add(userHandle);
+        // Remove from overlapping waitlists
+        removeFromOverlappingWaitlists(userHandle, conferenceHandle);
+    } else {
         // Add to waitlist
-        waitlists[conferenceName].push(bookingId);
+        waitlists[conferenceHandle].push(bookingHandle);
     }
+    indexActiveBooking(bookingHandle);
 
-    bookings.emplace(bookingId, newBooking);
-    
-    // Add the booking to the user's bookingStatuses map
-    users.at(userId).addBooking(bookingId, newBooking.getStatus());
+    User & user = users[userHandle];
+    if (newBooking.getStatus() == BookingStatus::CONFIRMED) {
+        user.addConfirmedWindow(conference.getStartTime(), conference.getEndTime(), bookingHandle);
+    } else {
+        user.addWaitlistedBooking(bookingHandle, conferenceHandle);
+    }
 
-    
-    // const User & user = users.at(userId);
-    //     auto activeBookings = user.getActiveBookings();
-    // cout << userId << " " << bookingId << " " << activeBookings.size() << "\n";
-    
-    cout << "Booking created with ID: " << bookingId << endl;
+
+    log() << "Booking created with ID: " << bookingId << endl;
 
     return bookingId;
 }
 
+// A status poll holds the booking's stripe shared only while it copies the
+// booking out, so polls run in parallel with each other and a booker waits
+// at most for one lookup; logging happens after the lock is released.
 BookingStatus ConferenceBookingSystem::getBookingStatus(const string & bookingId) const {
-    cout << "Checking status for booking: " << bookingId << endl;
+    log() << "Checking status for booking: " << bookingId << endl;
 
-    auto it = bookings.find(bookingId);
-    if (it == bookings.end()) {
+    BookingId id;
+    if (!BookingIdGenerator::decode(bookingId, id)) {
         throw runtime_error("Booking not found");
     }
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    const ConferenceStripe & stripe = stripes[BookingIdGenerator::shardOf(id)];
+    shared_lock<shared_mutex> stripe_lock(stripe.lock);
+
+    // Compacted bookings keep only their final status
+    const BookingStatus * archived = stripe.archivedBookings.find(id);
+    if (archived && !stripe.bookingHandles.find(id)) {
+        BookingStatus status = * archived;
+        stripe_lock.unlock();
+        log() << "Status: " << status << " (archived)" << endl;
+        return status;
+    }
 
-    const Booking & booking = it -> second;
+    Handle bookingHandle = resolveBooking(bookingId);
+    Booking booking = bookingAt(bookingHandle);
+    bool offered = stripe.offers.contains(bookingHandle);
+    stripe_lock.unlock();
     BookingStatus status = booking.getStatus();
 
-    cout << "Status: " << status << endl;
-    if (status == BookingStatus::WAITLISTED) {
-        const auto & conference = conferences.at(booking.getConferenceName());
-        if (conference.hasSlotAvailable()) {
-            Timestamp deadline = booking.getConfirmationDeadline();
-            cout << "Slot is available for confirmation until: " <<
-                ctime( & deadline.time);
-        }
+    log() << "Status: " << status << endl;
+    if (status == BookingStatus::WAITLISTED && offered) {
+        Timestamp deadline = booking.getConfirmationDeadline();
+        char text[26];
+        log() << "Slot is available for confirmation until: " <<
+            ctime_r( & deadline.time, text);
     }
 
     return status;
 }
 
-void ConferenceBookingSystem::validateConferenceExists(const string & name) const {
-    if (conferences.find(name) == conferences.end()) {
+Handle ConferenceBookingSystem::resolveConference(const string & name) const {
+    Handle handle = conferenceIds.find(name);
+    if (handle == INVALID_HANDLE) {
         throw runtime_error("Conference not found");
     }
+    return handle;
 }
 
-void ConferenceBookingSystem::validateUserExists(const string & userId) const {
-    if (users.find(userId) == users.end()) {
+Handle ConferenceBookingSystem::resolveUser(const string & userId) const {
+    Handle handle = userIds.find(userId);
+    if (handle == INVALID_HANDLE) {
         throw runtime_error("User not found");
     }
+    return handle;
 }
 
-string ConferenceBookingSystem::generateBookingId() const {
-    // Simple implementation for now
-    return to_string(time(nullptr)) + "_" + to_string(rand());
+Handle ConferenceBookingSystem::resolveBooking(const string & bookingId) const {
+    BookingId id;
+    if (!BookingIdGenerator::decode(bookingId, id)) {
+        throw runtime_error("Booking not found");
+    }
+    const Handle * handle = stripes[BookingIdGenerator::shardOf(id)].bookingHandles.find(id);
+    if (!handle) {
+        throw runtime_error("Booking not found");
+    }
+    return * handle;
 }
 
-bool ConferenceBookingSystem::confirmWaitlistedBooking(const string & bookingId) {
-    lock_guard<mutex> conf_lock(conference_mutex);
-    lock_guard<mutex> book_lock(booking_mutex);
-    lock_guard<mutex> wait_lock(waitlist_mutex);
-    cout << "Attempting to confirm waitlisted booking: " << bookingId << endl;
-
-    auto bookingIt = bookings.find(bookingId);
-    if (bookingIt == bookings.end()) {
+// Copy of a live booking, read under its stripe lock
+Booking ConferenceBookingSystem::snapshotBooking(const string & bookingId, bool confirming) const {
+    BookingId id;
+    if (!BookingIdGenerator::decode(bookingId, id)) {
         throw runtime_error("Booking not found");
     }
+    shared_lock<shared_mutex> stripe_lock(stripes[BookingIdGenerator::shardOf(id)].lock);
+    rejectArchivedBooking(bookingId, confirming);
+    return bookingAt(resolveBooking(bookingId));
+}
 
-    Booking & booking = bookingIt -> second;
-    if (booking.getStatus() != BookingStatus::WAITLISTED) {
-        throw runtime_error("Booking is not in waitlisted state");
+// A compacted booking cannot be canceled or confirmed, and says why the way
+// its live record would have: it was canceled, or its conference started.
+// Read under the booking's stripe lock.
+void ConferenceBookingSystem::rejectArchivedBooking(const string & bookingId, bool confirming) const {
+    BookingId id;
+    if (!BookingIdGenerator::decode(bookingId, id)) {
+        return;
+    }
+    const ConferenceStripe & stripe = stripes[BookingIdGenerator::shardOf(id)];
+    const BookingStatus * archived = stripe.archivedBookings.find(id);
+    if (!archived || stripe.bookingHandles.find(id)) {
+        return;
+    }
+    if (confirming) {
+        if ( * archived != BookingStatus::WAITLISTED) {
+            throw runtime_error("Booking is not in waitlisted state");
+        }
+        throw runtime_error("Cannot confirm booking after conference has started");
+    }
+    if ( * archived == BookingStatus::CANCELED) {
+        throw runtime_error("Booking is already canceled");
     }
+    throw runtime_error("Cannot cancel booking after conference has started");
+}
 
-    const string & conferenceName = booking.getConferenceName();
-    Conference & conference = conferences.at(conferenceName);
+// Conference stripes that booking or confirming a seat for the user may
+// touch: the conference's own, those of the user's overlapping waitlisted
+// bookings (which a confirmed seat cancels) and that of a conflicting
+// booking (whose id is logged). Read under the user's stripe lock.
+uint64_t ConferenceBookingSystem::stripesForBooking(Handle userHandle, Handle conference) const {
+    const User & user = users[userHandle];
+    const Conference & conf = conferences[conference];
+    uint64_t mask = stripeBit(conference);
+    user.getWaitlistedBookings().forEach([ & ](Handle booking, Handle waitlisted) {
+        if (conferences[waitlisted].isTimeOverlapping(conf.getStartTime(), conf.getEndTime())) {
+            mask |= stripeBit(booking);
+        }
+    });
+    Handle conflicting = user.findConflictingWindow(conf.getStartTime(), conf.getEndTime());
+    if (conflicting != INVALID_HANDLE) {
+        mask |= stripeBit(conflicting);
+    }
+    return mask;
+}
 
-    // Check if conference has started
-    if (conference.hasStarted()) {
-        cancelAllWaitlistedBookings(conferenceName);
-        throw runtime_error("Cannot confirm booking after conference has started");
+const VenueIndex::Schedule & ConferenceBookingSystem::resolveVenue(const string & location) const {
+    const VenueIndex::Schedule * schedule = venues.find(location);
+    if (!schedule) {
+        throw runtime_error("Location not found");
     }
+    return * schedule;
+}
 
-    // Check if confirmation deadline has passed
-    if (time(nullptr) > booking.getConfirmationDeadline().time) {
-        cout << "Confirmation deadline has passed" << endl;
-        // Move to end of waitlist
-        auto & waitlist = waitlists[conferenceName];
-        queue < string > updatedQueue;
-        bool foundCurrent = false;
-
-        // Remove from current position
-        while (!waitlist.empty()) {
-            string currentId = waitlist.front();
-            waitlist.pop();
-            if (currentId != bookingId) {
-                updatedQueue.push(currentId);
-            } else {
-                foundCurrent = true;
+// A conference's topics, interning the new ones: their mask, and each
+// distinct topic's handle in `handles`. Users already waiting on a new
+// topic get its bit.
+TopicMask ConferenceBookingSystem::internTopics(const vector < string > & topics, vector < Handle > & handles) {
+    TopicMask mask;
+    for (const string & topic: topics) {
+        Handle handle = topicIds.find(topic);
+        if (handle != INVALID_HANDLE && find(handles.begin(), handles.end(), handle) != handles.end()) {
+            continue;
+        }
+        if (handle == INVALID_HANDLE) {
+            handle = topicIds.intern(topic);
+            if (vector < Handle > * waiting = pendingInterests.find(topic)) {
+                for (Handle user: * waiting) {
+                    users[user].addInterest(handle);
+                }
+                pendingInterests.erase(topic);
             }
         }
+        mask.set(handle);
+        handles.push_back(handle);
+    }
+    return mask;
+}
 
-        // Add to end if it was found
-        if (foundCurrent) {
-            updatedQueue.push(bookingId);
+// A new user's interests: bits for topics the catalog has, and a place in
+// pendingInterests for the rest
+TopicMask ConferenceBookingSystem::userTopics(const vector < string > & topics, Handle user) {
+    TopicMask mask;
+    for (const string & topic: topics) {
+        Handle handle = topicIds.find(topic);
+        if (handle != INVALID_HANDLE) {
+            mask.set(handle);
+            continue;
         }
+        vector < Handle > & waiting = pendingInterests[topic];
+        if (waiting.empty() || waiting.back() != user) {
+            waiting.push_back(user);
+        }
+    }
+    return mask;
+}
+
+// Sharded by conference, so bookings for different conferences never touch
+// the same counter
+BookingId ConferenceBookingSystem::generateBookingId(Handle conference) {
+    return bookingIdGenerator.next(conference);
+}
+
+// Each stripe's wheel is advanced under that stripe's lock; processing an
+// offer only touches the offer's own conference.
+size_t ConferenceBookingSystem::expireWaitlistOffers() {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+
+    time_t now = time(nullptr);
+    size_t expired = 0;
+    for (ConferenceStripe & stripe: stripes) {
+        lock_guard<shared_mutex> stripe_lock(stripe.lock);
+        stripe.offers.advance(now, [ & ](Handle bookingHandle) {
+            Handle conferenceHandle = bookingAt(bookingHandle).getConference();
+            log() << "Offer expired for booking: " << bookingIdOf(bookingHandle) << endl;
+            waitlists[conferenceHandle].moveToBack(bookingHandle);
+            expired++;
+
+            // The timer is gone, so hand its seat on here
+            processWaitlist(conferenceHandle);
+        });
+    }
+    return expired;
+}
 
-        waitlists[conferenceName] = updatedQueue;
+// Driven by the calendar, so each pass visits only the conferences that
+// started since the previous one. Canceling a waitlist updates arbitrary
+// users, so the pass holds every user stripe.
+size_t ConferenceBookingSystem::releaseStartedWaitlists() {
+    lock_guard<mutex> sweep_lock(sweep_mutex);
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+
+    time_t now = time(nullptr);
+    vector < Handle > started;
+    uint64_t mask = 0;
+    calendar.forEachStarting(startedSweptUntil, now + 1, nullptr, [ & ](Handle conference) {
+        started.push_back(conference);
+        mask |= stripeBit(conference);
+        return true;
+    });
+    size_t canceled = 0;
+    if (!started.empty()) {
+        StripeLock<const UserStripe> user_lock(userStripes, ALL_STRIPES);
+        StripeLock<const ConferenceStripe> conference_lock(stripes, mask);
+        for (Handle conference: started) {
+            canceled += cancelAllWaitlistedBookings(conference);
+        }
+    }
+    startedSweptUntil = max(startedSweptUntil, now + 1);
+    return canceled;
+}
 
-        // Process next in waitlist if slot is still available
-        if (conference.hasSlotAvailable()) {
-            processWaitlist(conferenceName);
+// Bookings of ended conferences are found by scanning each stripe's pool,
+// one batch per lock acquisition so booking traffic is never blocked for a
+// full pass. The scan only runs when some conference has ended since the
+// last one.
+size_t ConferenceBookingSystem::compactBookings() {
+    lock_guard<mutex> sweep_lock(sweep_mutex);
+
+    size_t archived = 0;
+    for (ConferenceStripe & stripe: stripes) {
+        lock_guard<shared_mutex> stripe_lock(stripe.lock);
+        // Canceled bookings are already out of the user, waitlist and active
+        // indexes, so the id map is the only other reference
+        for (Handle bookingHandle: stripe.canceledBookings) {
+            archiveBooking(bookingHandle);
         }
+        archived += stripe.canceledBookings.size();
+        stripe.canceledBookings.clear();
+    }
 
-        return false;
+    time_t now = time(nullptr);
+    {
+        shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+        if (!hasConferenceEndedSince(endedSweptUntil, now)) {
+            return archived;
+        }
     }
 
-    if (hasConflictingBooking(booking.getUserId(), conference)) {
-        throw runtime_error("User now has a conflicting booking");
+    for (unsigned stripe = 0; stripe < LOCK_STRIPES; stripe++) {
+        Handle next = 0;
+        bool more = true;
+        while (more) {
+            shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+            StripeLock<const UserStripe> user_lock(userStripes, ALL_STRIPES);
+            lock_guard<shared_mutex> stripe_lock(stripes[stripe].lock);
+            size_t before = stripes[stripe].archivedBookings.size();
+            more = archiveEndedBookings(stripe, next, now);
+            archived += stripes[stripe].archivedBookings.size() - before;
+        }
     }
+    endedSweptUntil = max(endedSweptUntil, now);
+    return archived;
+}
+
+bool ConferenceBookingSystem::hasConferenceEndedSince(time_t since, time_t now) const {
+    bool ended = false;
+    calendar.forEachStarting(since - MAX_CONFERENCE_DURATION, now, nullptr, [ & ](Handle conference) {
+        time_t end = conferences[conference].getEndTime().time;
+        ended = end > since && end <= now;
+        return !ended;
+    });
+    return ended;
+}
 
-    // Check if slot is still available
-    if (!conference.decreaseAvailableSlots()) {
-        throw runtime_error("No slots available");
+// Archives bookings of ended conferences among the next batch of the
+// stripe's pool slots. Canceled records (and free slots, which read as
+// canceled) are left to the canceled list. Returns whether slots remain.
+bool ConferenceBookingSystem::archiveEndedBookings(unsigned stripe, Handle & next, time_t now) {
+    const Handle BATCH = 4096;
+    const SlabPool < Booking > & pool = stripes[stripe].bookings;
+    Handle stop = min < Handle > (pool.limit(), next + BATCH);
+    for (; next < stop; next++) {
+        Handle bookingHandle = next * LOCK_STRIPES + stripe;
+        const Booking & booking = pool[next];
+        if (booking.getStatus() == BookingStatus::CANCELED) {
+            continue;
+        }
+        const Conference & conference = conferences[booking.getConference()];
+        if (conference.getEndTime().time > now) {
+            continue;
+        }
+        User & user = users[booking.getUser()];
+        if (booking.getStatus() == BookingStatus::CONFIRMED) {
+            user.removeConfirmedWindow(conference.getStartTime());
+        } else {
+            waitlists[booking.getConference()].remove(bookingHandle);
+            if (stripes[stripe].offers.cancel(bookingHandle)) {
+                conferences[booking.getConference()].increaseAvailableSlots();
+            }
+        }
+        user.removeWaitlistedBooking(bookingHandle);
+        unindexActiveBooking(bookingHandle);
+        archiveBooking(bookingHandle);
     }
+    return next < pool.limit();
+}
 
-    // Remove from waitlist
-    auto & waitlist = waitlists[conferenceName];
-    queue < string > updatedQueue;
-    while (!waitlist.empty()) {
-        string currentId = waitlist.front();
-        waitlist.pop();
-        if (currentId != bookingId) {
-            updatedQueue.push(currentId);
+void ConferenceBookingSystem::startMaintenance(chrono::milliseconds compactionInterval) {
+    stopMaintenance();
+    maintenanceStopping = false;
+    maintenanceThread = thread([this, compactionInterval]() {
+        auto nextCompaction = chrono::steady_clock::now() + compactionInterval;
+        unique_lock<mutex> lock(maintenance_mutex);
+        while (!maintenanceWake.wait_for(lock, chrono::seconds(1), [this]() {
+                return maintenanceStopping;
+            })) {
+            lock.unlock();
+            expireWaitlistOffers();
+            releaseStartedWaitlists();
+            if (chrono::steady_clock::now() >= nextCompaction) {
+                compactBookings();
+                nextCompaction = chrono::steady_clock::now() + compactionInterval;
+            }
+            lock.lock();
         }
+    });
+}
+
+void ConferenceBookingSystem::stopMaintenance() {
+    if (!maintenanceThread.joinable()) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(maintenance_mutex);
+        maintenanceStopping = true;
+    }
+    maintenanceWake.notify_all();
+    maintenanceThread.join();
+}
+
+ConferenceBookingSystem::~ConferenceBookingSystem() {
+    stopMaintenance();
+}
+
+bool ConferenceBookingSystem::confirmWaitlistedBooking(const string & bookingId) {
+    shared_lock<DistributedSharedMutex> catalog_lock(catalog_mutex);
+    log() << "Attempting to confirm waitlisted booking: " << bookingId << endl;
+
+    Booking snapshot = snapshotBooking(bookingId, true);
+    if (snapshot.getStatus() != BookingStatus::WAITLISTED) {
+        throw runtime_error("Booking is not in waitlisted state");
+    }
+
+    Handle conferenceHandle = snapshot.getConference();
+    Conference conference = conferences[conferenceHandle];
+
+    // Check if conference has started. Releasing the waitlist needs every
+    // user stripe, so it runs as a sweep once this call's locks are dropped.
+    if (conference.hasStarted()) {
+        catalog_lock.unlock();
+        releaseStartedWaitlists();
+        throw runtime_error("Cannot confirm booking after conference has started");
+    }
+
+    StripeLock<const UserStripe> user_lock(userStripes, stripeBit(snapshot.getUser()));
+    StripeLock<const ConferenceStripe> conference_lock(stripes, stripesForBooking(snapshot.getUser(), conferenceHandle));
+    rejectArchivedBooking(bookingId, true);
+    Handle bookingHandle = resolveBooking(bookingId);
+    Booking & booking = bookingAt(bookingHandle);
+    if (booking.getStatus() != BookingStatus::WAITLISTED) {
+        throw runtime_error("Booking is not in waitlisted state");
+    }
+    // Started since the check above; the booking is still queued, so the
+    // start sweep will cancel it
+    if (conference.hasStarted()) {
+        throw runtime_error("Cannot confirm booking after conference has started");
+    }
+
+    // Without a live offer there is no seat to confirm yet; the booking keeps
+    // its place in the queue
+    ConferenceStripe & stripe = stripeOf(bookingHandle);
+    if (!stripe.offers.contains(bookingHandle)) {
+        throw runtime_error("No slot has been offered yet");
+    }
+
+    // Check if confirmation deadline has passed
+    if (time(nullptr) > booking.getConfirmationDeadline().time) {
+        log() << "Confirmation deadline has passed" << endl;
+        // Move to end of waitlist
+        waitlists[conferenceHandle].moveToBack(bookingHandle);
+        withdrawOffer(bookingHandle);
+        return false;
+    }
+
+    if (hasConflictingBooking(booking.getUser(), conference)) {
+        throw runtime_error("User now has a conflicting booking");
     }
-    waitlists[conferenceName] = updatedQueue;
+
+    // Take up the seat the offer holds
+    stripe.offers.cancel(bookingHandle);
+    waitlists[conferenceHandle].remove(bookingHandle);
 
     // Confirm the booking
     booking.setStatus(BookingStatus::CONFIRMED);
-    cout << "Booking confirmed successfully" << endl;
+    rosters[conferenceHandle].add(booking.getUser());
+    User & user = users[booking.getUser()];
+    user.removeWaitlistedBooking(bookingHandle);
+    user.addConfirmedWindow(conference.getStartTime(), conference.getEndTime(), bookingHandle);
+    log() << "Booking confirmed successfully" << endl;
 
     // Remove from overlapping waitlists
-    removeFromOverlappingWaitlists(booking.getUserId(), conference);
+    removeFromOverlappingWaitlists(booking.getUser(), conferenceHandle);
 
     return true;
 }
@@ -866,3 +3014,336 @@ bool ConferenceBookingSystem::confirmWaitlistedBooking(const string & bookingId)
 //     test_concurrent_booking();
 //     return 0;
 // }
+
+// // Behaviour checks for the maintenance paths: archival, offer expiry and the
+// // start-of-conference waitlist release. Each prints what it got next to what
+// // it should be, waiting a few seconds where a real deadline has to pass.
+// void test_archived_status() {
+//     ConferenceBookingSystem system;
+//     system.setLogging(false);
+//     vector<string> topics = {"C++", "Programming"};
+//     system.addConference("Archive Conf", "New York", topics, {time(nullptr) + 3600}, {time(nullptr) + 7200}, 1);
+//     system.addConference("Short Conf", "New York", topics, {time(nullptr) + 2}, {time(nullptr) + 3}, 1);
+//     system.addUser("user1", topics);
+//     system.addUser("user2", topics);
+
+//     string confirmedId = system.bookConference("user1", "Archive Conf");
+//     string canceledId = system.bookConference("user2", "Archive Conf");
+//     system.cancelBooking(canceledId);
+//     string endedId = system.bookConference("user2", "Short Conf");
+//     this_thread::sleep_for(chrono::seconds(4));
+
+//     cout << "Archived: " << system.compactBookings() << " (should be 2)\n";
+//     cout << "Canceled booking: " << system.getBookingStatus(canceledId) << " (should be CANCELED)\n";
+//     cout << "Booking of ended conference: " << system.getBookingStatus(endedId) << " (should be CONFIRMED)\n";
+//     cout << "Live booking: " << system.getBookingStatus(confirmedId) << " (should be CONFIRMED)\n";
+// }
+
+// void test_offer_rotation() {
+//     ConferenceBookingSystem system;
+//     system.setLogging(false);
+//     system.setOfferWindow(chrono::seconds(1));
+//     vector<string> topics = {"C++", "Programming"};
+//     system.addConference("Offer Conf", "New York", topics, {time(nullptr) + 3600}, {time(nullptr) + 7200}, 1);
+//     vector<string> ids;
+//     for(int i = 1; i <= 3; i++) {
+//         system.addUser("user" + to_string(i), topics);
+//         ids.push_back(system.bookConference("user" + to_string(i), "Offer Conf"));
+//     }
+
+//     // user2 is offered the freed seat and lets the offer lapse
+//     system.cancelBooking(ids[0]);
+//     this_thread::sleep_for(chrono::seconds(3));
+//     cout << "Expired offers: " << system.expireWaitlistOffers() << " (should be 1)\n";
+
+//     // The seat has passed to user3; user2 is now at the back without an offer
+//     try {
+//         system.confirmWaitlistedBooking(ids[1]);
+//         cout << "user2 confirmed without an offer (should have failed)\n";
+//     } catch (const exception& e) {
+//         cout << "Expected error: " << e.what() << "\n";
+//     }
+//     cout << "user3 confirms: " << system.confirmWaitlistedBooking(ids[2]) << " (should be 1)\n";
+//     cout << "user2 status: " << system.getBookingStatus(ids[1]) << " (should be WAITLISTED)\n";
+// }
+
+// void test_started_waitlist_release() {
+//     ConferenceBookingSystem system;
+//     system.setLogging(false);
+//     vector<string> topics = {"C++", "Programming"};
+//     system.addConference("Starting Conf", "New York", topics, {time(nullptr) + 2}, {time(nullptr) + 3600}, 1);
+//     system.addConference("Evening Conf", "New York", topics, {time(nullptr) + 1800}, {time(nullptr) + 5400}, 1);
+//     vector<string> ids;
+//     for(int i = 1; i <= 3; i++) {
+//         system.addUser("user" + to_string(i), topics);
+//         ids.push_back(system.bookConference("user" + to_string(i), "Starting Conf"));
+//     }
+//     this_thread::sleep_for(chrono::seconds(3));
+
+//     cout << "Released: " << system.releaseStartedWaitlists() << " (should be 2)\n";
+//     cout << "Released again: " << system.releaseStartedWaitlists() << " (should be 0)\n";
+//     cout << "user1 status: " << system.getBookingStatus(ids[0]) << " (should be CONFIRMED)\n";
+//     cout << "user2 status: " << system.getBookingStatus(ids[1]) << " (should be CANCELED)\n";
+//     cout << "user3 status: " << system.getBookingStatus(ids[2]) << " (should be CANCELED)\n";
+
+//     // The users no longer hold the released bookings: user2 books an
+//     // overlapping conference, and the old booking cannot be canceled again
+//     string evening = system.bookConference("user2", "Evening Conf");
+//     cout << "user2 evening booking: " << system.getBookingStatus(evening) << " (should be CONFIRMED)\n";
+//     try {
+//         system.cancelBooking(ids[1]);
+//         cout << "Canceled a released booking (should have failed)\n";
+//     } catch (const exception& e) {
+//         cout << "Expected error: " << e.what() << "\n";
+//     }
+// }
+
+// int main() {
+//     test_archived_status();
+//     test_offer_rotation();
+//     test_started_waitlist_release();
+//     return 0;
+// }
+
+// // Lookup and insert latency of the booking registry at 1M bookings: the
+// // original map<string, ...> keyed by text id against FlatHashMap keyed by
+// // the 64-bit id, plus the string_view lookup path used by SymbolTable.
+// template < typename Fn >
+// double nanosPerOp(size_t ops, Fn fn) {
+//     auto begin = chrono::steady_clock::now();
+//     fn();
+//     auto elapsed = chrono::steady_clock::now() - begin;
+//     return chrono::duration < double, nano > (elapsed).count() / ops;
+// }
+
+// void benchmark_registries() {
+//     const size_t N = 1000000;
+//     BookingIdGenerator generator;
+//     vector < BookingId > ids(N);
+//     vector < string > texts(N);
+//     for (size_t i = 0; i < N; i++) {
+//         ids[i] = generator.next(i % 64);
+//         texts[i] = BookingIdGenerator::encode(ids[i]);
+//     }
+//     vector < size_t > order(N);
+//     iota(order.begin(), order.end(), 0);
+//     shuffle(order.begin(), order.end(), mt19937(42));
+//     size_t sink = 0; // printed below, so the lookups cannot be optimized away
+
+//     map < string, Handle > ordered;
+//     double orderedInsert = nanosPerOp(N, [ & ]() {
+//         for (size_t i = 0; i < N; i++) ordered.emplace(texts[i], i);
+//     });
+//     double orderedLookup = nanosPerOp(N, [ & ]() {
+//         for (size_t i: order) sink += ordered.find(texts[i]) -> second;
+//     });
+
+//     unordered_map < BookingId, Handle > chained;
+//     double chainedInsert = nanosPerOp(N, [ & ]() {
+//         for (size_t i = 0; i < N; i++) chained.emplace(ids[i], i);
+//     });
+//     double chainedLookup = nanosPerOp(N, [ & ]() {
+//         for (size_t i: order) sink += chained.find(ids[i]) -> second;
+//     });
+
+//     FlatHashMap < BookingId, Handle > flat;
+//     double flatInsert = nanosPerOp(N, [ & ]() {
+//         for (size_t i = 0; i < N; i++) flat.insert(ids[i], i);
+//     });
+//     double flatLookup = nanosPerOp(N, [ & ]() {
+//         for (size_t i: order) sink += * flat.find(ids[i]);
+//     });
+
+//     FlatHashMap < string, Handle > flatText;
+//     double flatTextInsert = nanosPerOp(N, [ & ]() {
+//         for (size_t i = 0; i < N; i++) flatText.insert(texts[i], i);
+//     });
+//     double flatTextLookup = nanosPerOp(N, [ & ]() {
+//         for (size_t i: order) sink += * flatText.find(string_view(texts[i]));
+//     });
+
+//     cout << "ns/op at " << N << " bookings        insert   lookup\n";
+//     cout << "map<string, Handle>               " << orderedInsert << "   " << orderedLookup << "\n";
+//     cout << "unordered_map<BookingId, Handle>  " << chainedInsert << "   " << chainedLookup << "\n";
+//     cout << "FlatHashMap<BookingId, Handle>    " << flatInsert << "   " << flatLookup << "\n";
+//     cout << "FlatHashMap<string, Handle>       " << flatTextInsert << "   " << flatTextLookup << "\n";
+//     cout << "(checksum " << sink << ")\n";
+// }
+
+// int main() {
+//     benchmark_registries();
+//     return 0;
+// }
+
+// // Heap allocations per operation in steady-state booking: every user books
+// // and cancels, then canceled records are compacted, round after round. After
+// // the warm-up rounds have grown the pools and tables to their working set,
+// // book and cancel allocate nothing; compaction is counted on its own, as the
+// // archive it appends to keeps growing and doubles now and then.
+// atomic < size_t > allocationCount {
+//     0
+// };
+// void * operator new(size_t size) {
+//     allocationCount.fetch_add(1, memory_order_relaxed);
+//     if (void * p = malloc(size)) {
+//         return p;
+//     }
+//     throw bad_alloc();
+// }
+// // Not inlined, or GCC sees free() meet a new-expression and warns
+// // (-Wmismatched-new-delete)
+// [[gnu::noinline]] void operator delete(void * p) noexcept {
+//     free(p);
+// }
+// [[gnu::noinline]] void operator delete(void * p, size_t) noexcept {
+//     free(p);
+// }
+
+// void benchmark_steady_state_allocations() {
+//     const int USERS = 2000;
+//     const int ROUNDS = 20;
+//     const int WARMUP = 5;
+//     ConferenceBookingSystem system;
+//     Timestamp start {
+//         time(nullptr) + 3600
+//     };
+//     Timestamp end {
+//         time(nullptr) + 7200
+//     };
+//     // Fewer slots than users, so every round also fills and drains a waitlist
+//     system.addConference("Steady", "Pune", {
+//         "AI"
+//     }, start, end, USERS / 2);
+//     vector < string > userIds;
+//     for (int i = 0; i < USERS; i++) {
+//         userIds.push_back("user" + to_string(i));
+//         system.addUser(userIds.back(), {
+//             "AI"
+//         });
+//     }
+//     const string conference = "Steady";
+//     vector < string > bookingIds(USERS);
+//     streambuf * console = cout.rdbuf(nullptr);
+//     size_t measured = 0;
+//     size_t compaction = 0;
+//     for (int round = 0; round < ROUNDS; round++) {
+//         size_t before = allocationCount.load();
+//         for (int i = 0; i < USERS; i++) {
+//             bookingIds[i] = system.bookConference(userIds[i], conference);
+//         }
+//         for (int i = 0; i < USERS; i++) {
+//             system.cancelBooking(bookingIds[i]);
+//         }
+//         size_t booked = allocationCount.load();
+//         system.compactBookings();
+//         if (round >= WARMUP) {
+//             measured += booked - before;
+//             compaction += allocationCount.load() - booked;
+//         }
+//     }
+//     cout.rdbuf(console);
+//     size_t ops = size_t(ROUNDS - WARMUP) * USERS * 2;
+//     cout << "allocations over " << ops << " steady-state book/cancel ops: " << measured << " (should be 0)\n";
+//     cout << "allocations over " << ROUNDS - WARMUP << " compactions: " << compaction << " (archive growth)\n";
+// }
+
+// int main() {
+//     benchmark_steady_state_allocations();
+//     return 0;
+// }
+
+// // Stress version of test_concurrent_booking: 100k users booking from 64
+// // threads, spread over many conferences plus one hot conference, large
+// // enough to keep its seats in a SeatPool, that every tenth user also tries
+// // to book. Checks that no conference is oversold and
+// // every booking is either confirmed or waitlisted, and reports throughput
+// // against a single-threaded run of the same workload.
+// double stress_concurrent_booking(int threadCount) {
+//     const int USERS = 100000;
+//     const int CONFERENCES = 1000;
+//     const int SLOTS = 80;
+//     const int HOT_SLOTS = SHARDED_SEATS_THRESHOLD;
+//     ConferenceBookingSystem system;
+//     system.setLogging(false);
+
+//     vector < string > confTopics = {
+//         "C++",
+//         "Programming"
+//     };
+//     for (int c = 0; c < CONFERENCES; c++) {
+//         // Two-hour blocks so no user's two bookings overlap
+//         Timestamp startTime {
+//             time(nullptr) + 3600 + (c % 2) * 7200
+//         };
+//         Timestamp endTime {
+//             startTime.time + 3600
+//         };
+//         system.addConference("Conf" + to_string(c), "New York", confTopics, startTime, endTime, SLOTS);
+//     }
+//     system.addConference("Hot Conf", "New York", confTopics, {
+//         time(nullptr) + 3600 * 6
+//     }, {
+//         time(nullptr) + 3600 * 7
+//     }, HOT_SLOTS);
+//     vector < string > userIds(USERS);
+//     vector < string > userTopics = {
+//         "C++",
+//         "Software"
+//     };
+//     for (int i = 0; i < USERS; i++) {
+//         userIds[i] = "user" + to_string(i);
+//         system.addUser(userIds[i], userTopics);
+//     }
+
+//     vector < vector < string >> bookingIds(threadCount);
+//     atomic < int > errors {
+//         0
+//     };
+//     auto begin = chrono::steady_clock::now();
+//     vector < thread > threads;
+//     for (int t = 0; t < threadCount; t++) {
+//         threads.emplace_back([ & , t]() {
+//             for (int i = t; i < USERS; i += threadCount) {
+//                 try {
+//                     bookingIds[t].push_back(system.bookConference(userIds[i], "Conf" + to_string(i % CONFERENCES)));
+//                     if (i % 10 == 0) {
+//                         bookingIds[t].push_back(system.bookConference(userIds[i], "Hot Conf"));
+//                     }
+//                 } catch (const exception & e) {
+//                     errors++;
+//                 }
+//             }
+//         });
+//     }
+//     for (auto & thread: threads) {
+//         thread.join();
+//     }
+//     double seconds = chrono::duration < double > (chrono::steady_clock::now() - begin).count();
+
+//     int confirmed = 0;
+//     int waitlisted = 0;
+//     for (auto & ids: bookingIds) {
+//         for (auto & id: ids) {
+//             BookingStatus status = system.getBookingStatus(id);
+//             if (status == BookingStatus::CONFIRMED) confirmed++;
+//             if (status == BookingStatus::WAITLISTED) waitlisted++;
+//         }
+//     }
+//     size_t attendees = system.getAttendeeCount("Hot Conf");
+//     for (int c = 0; c < CONFERENCES; c++) {
+//         attendees += system.getAttendeeCount("Conf" + to_string(c));
+//     }
+//     size_t bookings = USERS + USERS / 10;
+//     size_t seats = CONFERENCES * SLOTS + HOT_SLOTS;
+//     cout << threadCount << " threads: " << bookings / seconds << " bookings/s, errors " << errors
+//         << ", confirmed " << confirmed << " (should be " << seats << ", roster " << attendees
+//         << "), waitlisted " << waitlisted << " (should be " << bookings - seats << ")\n";
+//     return seconds;
+// }
+
+// int main() {
+//     double single = stress_concurrent_booking(1);
+//     double parallel = stress_concurrent_booking(64);
+//     cout << "speedup: " << single / parallel << "\n";
+//     return 0;
+// }